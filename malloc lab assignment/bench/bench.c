@@ -0,0 +1,250 @@
+// bench : 모든 변형 x 모든 트레이스를 변형별 replay 실행 파일로 병렬 재생하고 표와 JSON 으로 정리
+//
+//   bench [-j 동시 실행 수] [-o 결과.json] [-b replay 디렉터리] [트레이스.rep ...]
+//
+// 변형마다 따로 링크한 replay 실행 파일(build/mm_*)을 (변형, 트레이스) 쌍마다 프로세스 하나로 띄움.
+// 변형끼리 전역 상태와 mem_sbrk 힙을 나누지 않고, 한 쌍이 죽어도 나머지는 계속됨.
+// 트레이스를 안 주면 traces/*.rep 전부.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <glob.h>
+
+#include <sys/wait.h>
+
+#define OUT_MAX     512     // replay 결과 한 줄 최대 길이
+
+typedef struct {
+    const char* variant;    // 변형 이름 (mm_1 ...)
+    const char* trace;      // 트레이스 경로
+    pid_t pid;              // 실행 중인 replay (0 이면 아직 / 끝남)
+    int fd;                 // replay 표준 출력 파이프
+    char out[OUT_MAX];      // replay 가 출력한 JSON 한 줄
+    int ok;                 // 성공 여부
+    double util;            // 최대 사용률
+    double ops_per_sec;     // 초당 연산 수
+} job_t;
+
+static int variant_cmp(const void* a, const void* b);
+static int list_variants(const char* dir, char*** names);
+static void start_job(job_t* j, const char* dir);
+static void finish_job(job_t* j, int status);
+static double json_num(const char* out, const char* key);
+
+int main(int argc, char** argv)
+{
+    const char* dir = "build"; // replay 실행 파일 디렉터리
+    const char* json_path = NULL; // JSON 결과 파일
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN); // 동시 실행 수
+    char** variants;
+    int nvariants;
+    glob_t traces; // 재생할 트레이스 목록
+    job_t* job;
+    int njobs, next = 0, running = 0;
+    int opt, status;
+    pid_t pid;
+    FILE* fp;
+
+    while ((opt = getopt(argc, argv, "j:o:b:")) != -1) {
+        switch (opt) {
+        case 'j': jobs = atol(optarg); break;
+        case 'o': json_path = optarg; break;
+        case 'b': dir = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-j jobs] [-o out.json] [-b dir] [trace.rep ...]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (jobs < 1) {
+        jobs = 1;
+    }
+
+    if ((nvariants = list_variants(dir, &variants)) <= 0) {
+        fprintf(stderr, "bench: no replay binaries in %s (run make first)\n", dir);
+        return 1;
+    }
+    if (optind < argc) { // 인자로 준 트레이스
+        memset(&traces, 0, sizeof(traces));
+        traces.gl_pathc = argc - optind;
+        traces.gl_pathv = argv + optind;
+    }
+    else if (glob("traces/*.rep", 0, NULL, &traces) != 0) {
+        fprintf(stderr, "bench: no traces found\n");
+        return 1;
+    }
+
+    // (변형, 트레이스) 쌍마다 작업 하나
+    njobs = nvariants * (int)traces.gl_pathc;
+    job = calloc(njobs, sizeof(job_t));
+    for (int v = 0; v < nvariants; v++) {
+        for (size_t t = 0; t < traces.gl_pathc; t++) {
+            job[v * traces.gl_pathc + t].variant = variants[v];
+            job[v * traces.gl_pathc + t].trace = traces.gl_pathv[t];
+        }
+    }
+
+    // 동시에 jobs 개까지 띄우고 하나 끝날 때마다 다음 작업
+    while (next < njobs || running > 0) {
+        while (next < njobs && running < jobs) {
+            start_job(&job[next++], dir);
+            running++;
+        }
+        if ((pid = wait(&status)) == -1) {
+            break;
+        }
+        for (int i = 0; i < next; i++) {
+            if (job[i].pid == pid) {
+                finish_job(&job[i], status);
+                running--;
+                break;
+            }
+        }
+    }
+
+    // 표 : 트레이스별 결과와 변형별 평균
+    printf("%-26s %-20s %6s %8s %12s\n", "variant", "trace", "ok", "util", "Kops/s");
+    for (int v = 0; v < nvariants; v++) {
+        double util = 0, kops = 0; // 평균
+        int ok = 0;
+
+        for (size_t t = 0; t < traces.gl_pathc; t++) {
+            job_t* j = &job[v * traces.gl_pathc + t];
+            const char* name = strrchr(j->trace, '/') ? strrchr(j->trace, '/') + 1 : j->trace;
+
+            if (j->ok) {
+                printf("%-26s %-20s %6s %7.1f%% %12.1f\n", j->variant, name, "ok", j->util * 100, j->ops_per_sec / 1000);
+                util += j->util;
+                kops += j->ops_per_sec / 1000;
+                ok++;
+            }
+            else {
+                printf("%-26s %-20s %6s %8s %12s\n", j->variant, name, "FAIL", "-", "-");
+            }
+        }
+        if (ok > 0) {
+            printf("%-26s %-20s %3d/%-2zu %7.1f%% %12.1f\n\n", variants[v], "(average)", ok, traces.gl_pathc, util / ok * 100, kops / ok);
+        }
+        else {
+            printf("%-26s %-20s %3d/%-2zu %8s %12s\n\n", variants[v], "(average)", ok, traces.gl_pathc, "-", "-");
+        }
+    }
+
+    // JSON : replay 결과 줄들을 배열로
+    if (json_path != NULL) {
+        if ((fp = fopen(json_path, "w")) == NULL) {
+            perror(json_path);
+            return 1;
+        }
+        fprintf(fp, "[\n");
+        for (int i = 0; i < njobs; i++) {
+            fprintf(fp, "  %s%s\n", job[i].out, (i + 1 < njobs) ? "," : "");
+        }
+        fprintf(fp, "]\n");
+        fclose(fp);
+    }
+    return 0;
+}
+
+// variant_cmp : mm_2 가 mm_10 보다 앞이도록 번호순 (정렬 빌드 mm_9_a16 은 mm_9 바로 뒤), 번호 없는 엔진 조합(mm_e_*)은 뒤에 이름순
+static int variant_cmp(const void* a, const void* b)
+{
+    const char* x = *(const char* const*)a;
+    const char* y = *(const char* const*)b;
+    int x_num = isdigit((unsigned char)x[3]);
+    int y_num = isdigit((unsigned char)y[3]);
+
+    if (x_num != y_num) {
+        return y_num - x_num;
+    }
+    if (x_num && atol(x + 3) != atol(y + 3)) {
+        return (atol(x + 3) < atol(y + 3)) ? -1 : 1;
+    }
+    return strcmp(x, y);
+}
+
+// list_variants : dir 안의 mm_* 실행 파일 이름들 (번호순)
+static int list_variants(const char* dir, char*** names)
+{
+    DIR* d = opendir(dir);
+    struct dirent* e;
+    char path[4096];
+    int n = 0, cap = 16;
+
+    if (d == NULL) {
+        return -1;
+    }
+    *names = malloc(cap * sizeof(char*));
+    while ((e = readdir(d)) != NULL) {
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        if (strncmp(e->d_name, "mm_", 3) != 0 || access(path, X_OK) != 0) {
+            continue;
+        }
+        if (n == cap) {
+            *names = realloc(*names, (cap *= 2) * sizeof(char*));
+        }
+        (*names)[n++] = strdup(e->d_name);
+    }
+    closedir(d);
+    qsort(*names, n, sizeof(char*), variant_cmp);
+    return n;
+}
+
+// start_job : replay 프로세스를 띄우고 표준 출력을 파이프로
+static void start_job(job_t* j, const char* dir)
+{
+    int fds[2];
+    char path[4096];
+
+    snprintf(path, sizeof(path), "%s/%s", dir, j->variant);
+    if (pipe(fds) == -1 || (j->pid = fork()) == -1) {
+        perror("bench");
+        exit(1);
+    }
+    if (j->pid == 0) { // 자식 : replay <변형> <트레이스>
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execl(path, path, j->variant, j->trace, (char*)NULL);
+        _exit(127);
+    }
+    close(fds[1]);
+    j->fd = fds[0];
+}
+
+// finish_job : 끝난 replay 의 출력 읽기 (결과가 한 줄이라 파이프 버퍼에 다 들어 있음)
+static void finish_job(job_t* j, int status)
+{
+    ssize_t n = read(j->fd, j->out, OUT_MAX - 1);
+    const char* name = strrchr(j->trace, '/') ? strrchr(j->trace, '/') + 1 : j->trace;
+
+    close(j->fd);
+    j->pid = 0;
+    j->out[(n > 0) ? n : 0] = '\0';
+    j->out[strcspn(j->out, "\n")] = '\0';
+
+    if (WIFSIGNALED(status)) { // 죽었으면 replay 대신 결과 줄 만들기
+        snprintf(j->out, OUT_MAX, "{\"variant\":\"%s\",\"trace\":\"%s\",\"ok\":false,\"error\":\"signal %d\"}",
+            j->variant, name, WTERMSIG(status));
+    }
+    else if (j->out[0] == '\0') {
+        snprintf(j->out, OUT_MAX, "{\"variant\":\"%s\",\"trace\":\"%s\",\"ok\":false,\"error\":\"exit %d\"}",
+            j->variant, name, WEXITSTATUS(status));
+    }
+    j->ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && strstr(j->out, "\"ok\":true") != NULL;
+    if (j->ok) {
+        j->util = json_num(j->out, "\"util\":");
+        j->ops_per_sec = json_num(j->out, "\"ops_per_sec\":");
+    }
+}
+
+// json_num : 결과 줄에서 key 뒤의 숫자
+static double json_num(const char* out, const char* key)
+{
+    const char* p = strstr(out, key);
+
+    return (p != NULL) ? atof(p + strlen(key)) : 0;
+}
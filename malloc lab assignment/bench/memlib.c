@@ -0,0 +1,80 @@
+// memlib.c : mem_sbrk 힙 시뮬레이터
+// MAX_HEAP 만큼 주소 공간을 한 번에 예약해 두고 brk 만 앞뒤로 옮김 (실제 페이지는 처음 쓸 때 잡힘)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <sys/mman.h>
+
+#include "memlib.h"
+
+#ifndef MAX_HEAP
+#define MAX_HEAP    ((size_t)1 << (sizeof(void*) == 4 ? 28 : 30))  // 힙 최대 크기 (버디처럼 두 배씩 늘리는 변형도 들어가게)
+#endif
+
+static char* mem_start_brk; // 힙 시작
+static char* mem_brk;       // 현재 끝 (다음 mem_sbrk 가 돌려줄 주소)
+static char* mem_max_addr;  // 예약 끝
+
+// mem_init : 힙 주소 공간 예약
+void mem_init(void)
+{
+    mem_start_brk = mmap(NULL, MAX_HEAP, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem_start_brk == MAP_FAILED) {
+        fprintf(stderr, "mem_init: mmap failed\n");
+        exit(1);
+    }
+    mem_max_addr = mem_start_brk + MAX_HEAP;
+    mem_brk = mem_start_brk;
+}
+
+// mem_deinit : 예약 해제
+void mem_deinit(void)
+{
+    munmap(mem_start_brk, MAX_HEAP);
+}
+
+// mem_reset_brk : 힙을 빈 상태로 (이전 내용은 페이지째 버림)
+void mem_reset_brk(void)
+{
+    madvise(mem_start_brk, mem_brk - mem_start_brk, MADV_DONTNEED);
+    mem_brk = mem_start_brk;
+}
+
+// mem_sbrk : 힙을 incr 만큼 늘리고 옛 끝을 돌려줌, 실패하면 (void*)-1
+void* mem_sbrk(int incr)
+{
+    char* old_brk = mem_brk;
+
+    if (incr < 0 || incr > mem_max_addr - mem_brk) {
+        errno = ENOMEM;
+        return (void*)-1;
+    }
+    mem_brk += incr;
+    return old_brk;
+}
+
+// mem_heap_lo : 힙 첫 바이트
+void* mem_heap_lo(void)
+{
+    return mem_start_brk;
+}
+
+// mem_heap_hi : 힙 마지막 바이트
+void* mem_heap_hi(void)
+{
+    return mem_brk - 1;
+}
+
+// mem_heapsize : 힙 크기
+size_t mem_heapsize(void)
+{
+    return (size_t)(mem_brk - mem_start_brk);
+}
+
+// mem_pagesize : 페이지 크기
+size_t mem_pagesize(void)
+{
+    return (size_t)getpagesize();
+}
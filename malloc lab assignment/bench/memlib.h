@@ -0,0 +1,20 @@
+// memlib.h : mem_sbrk 힙 시뮬레이터
+
+#include <unistd.h>
+
+#ifdef __cplusplus // C++ 엔진(engine/)에서도 포함
+extern "C" {
+#endif
+
+void mem_init(void);
+void mem_deinit(void);
+void* mem_sbrk(int incr);
+void mem_reset_brk(void);
+void* mem_heap_lo(void);
+void* mem_heap_hi(void);
+size_t mem_heapsize(void);
+size_t mem_pagesize(void);
+
+#ifdef __cplusplus
+}
+#endif
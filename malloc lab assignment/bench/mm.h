@@ -0,0 +1,29 @@
+// mm.h : 변형(mm_*.c)들이 구현하는 할당기 인터페이스
+
+#include <stdio.h>
+
+#ifdef __cplusplus // C++ 엔진(engine/)에서도 포함
+extern "C" {
+#endif
+
+extern int mm_init(void);
+extern void* mm_malloc(size_t size);
+extern void mm_free(void* ptr);
+extern void* mm_realloc(void* ptr, size_t size);
+
+// 선택 : 있는 변형만 정의 (preload 가 약한 참조로 사용)
+extern size_t mm_usable_size(void* ptr);
+extern void* mm_memalign(size_t alignment, size_t size);
+extern void* mm_aligned_alloc(size_t alignment, size_t size);
+extern size_t mm_malloc_batch(size_t size, size_t n, void** out);
+extern int mm_malloc_multi(size_t n, const size_t* sizes, void** out);
+extern void mm_free_batch(void** ptrs, size_t n);
+extern void mm_free_sized(void* ptr, size_t size);
+extern size_t mm_footprint(void);
+extern void mm_atfork_prepare(void);
+extern void mm_atfork_parent(void);
+extern void mm_atfork_child(void);
+
+#ifdef __cplusplus
+}
+#endif
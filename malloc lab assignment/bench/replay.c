@@ -0,0 +1,266 @@
+// replay : 변형 하나(mm_*.c)에 링크해서 CS:APP 형식 .rep 트레이스를 재생하고 결과를 JSON 한 줄로 출력
+//
+//   replay <변형 이름> <트레이스.rep>
+//
+// 1) 검사 재생 : 블록마다 내용을 채워 두고 free/realloc 때 확인 (겹침, 정렬, realloc 내용 보존)
+//    살아 있는 페이로드 합의 최대값 / 힙 크기의 최대값 = 최대 사용률
+//    힙 크기는 mem_sbrk 힙, 변형이 mm_footprint 를 정의하면 그 값 (mmap 아레나, slab, mmap 블록까지)
+// 2) 시간 재생 : 검사 없이 MIN_TIME 이 넘을 때까지 반복해서 ops/sec
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mm.h"
+#include "memlib.h"
+
+#pragma weak mm_footprint
+
+#define MIN_TIME    0.2     // 시간 재생 최소 시간 (초)
+#ifndef ALIGNMENT
+#define ALIGNMENT   8       // 페이로드 정렬 (정렬 빌드는 -DALIGNMENT=16 ...)
+#endif
+
+typedef struct {
+    char type;      // 'a' 할당, 'f' 해제, 'r' 재할당
+    int id;         // 블록 번호
+    size_t size;    // 요청 크기
+} op_t;
+
+typedef struct {
+    int num_ids;    // 블록 번호 수
+    int num_ops;    // 연산 수
+    op_t* ops;
+} trace_t;
+
+static const char* variant; // 출력용 변형 이름
+static const char* trace_name; // 출력용 트레이스 이름
+
+static void fail(const char* fmt, int op, int id);
+static int read_trace(const char* path, trace_t* t);
+static void check_run(trace_t* t, double* util, size_t* heap);
+static size_t footprint(void);
+static double time_run(trace_t* t);
+static double now_sec(void);
+
+int main(int argc, char** argv)
+{
+    trace_t t;
+    double util; // 최대 사용률
+    size_t heap; // 최대 힙 크기
+    double secs; // 한 번 재생에 걸린 시간
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <variant> <trace.rep>\n", argv[0]);
+        return 2;
+    }
+    variant = argv[1];
+    trace_name = strrchr(argv[2], '/') ? strrchr(argv[2], '/') + 1 : argv[2];
+
+    if (read_trace(argv[2], &t) == -1) {
+        fail("cannot read trace", -1, -1);
+    }
+    mem_init();
+
+    check_run(&t, &util, &heap);
+    secs = time_run(&t);
+
+    printf("{\"variant\":\"%s\",\"trace\":\"%s\",\"ok\":true,\"ops\":%d,\"util\":%.4f,\"heap\":%zu,\"ops_per_sec\":%.0f}\n",
+        variant, trace_name, t.num_ops, util, heap, t.num_ops / secs);
+    mem_deinit();
+    return 0;
+}
+
+// fail : 실패 결과를 JSON 한 줄로 출력하고 종료
+static void fail(const char* msg, int op, int id)
+{
+    printf("{\"variant\":\"%s\",\"trace\":\"%s\",\"ok\":false,\"error\":\"%s\",\"op\":%d,\"id\":%d}\n",
+        variant, trace_name, msg, op, id);
+    exit(1);
+}
+
+// read_trace : 트레이스를 mmap 으로 읽어 연산 배열로
+// 머리 4줄 (권장 힙 크기, 블록 번호 수, 연산 수, 가중치) 다음 한 줄에 하나씩 "a id size" / "f id" / "r id size"
+static int read_trace(const char* path, trace_t* t)
+{
+    int fd;
+    struct stat st;
+    char* text; // 파일 내용
+    char* p;
+    char* end;
+    long head[4]; // 머리 4줄
+    int n = 0; // 읽은 연산 수
+
+    if ((fd = open(path, O_RDONLY)) == -1 || fstat(fd, &st) == -1 || st.st_size == 0) {
+        return -1;
+    }
+    text = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) {
+        return -1;
+    }
+    end = text + st.st_size;
+    p = text;
+
+    for (int i = 0; i < 4; i++) { // strtol 은 줄바꿈도 공백으로 건너뜀
+        head[i] = strtol(p, &p, 10);
+    }
+    t->num_ids = (int)head[1];
+    t->num_ops = (int)head[2];
+    if (t->num_ids <= 0 || t->num_ops <= 0 || (t->ops = calloc(t->num_ops, sizeof(op_t))) == NULL) {
+        munmap(text, st.st_size);
+        return -1;
+    }
+
+    while (p < end && n < t->num_ops) {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+            p++;
+        }
+        if (p >= end) {
+            break;
+        }
+        t->ops[n].type = *p++;
+        t->ops[n].id = (int)strtol(p, &p, 10);
+        if (t->ops[n].type == 'a' || t->ops[n].type == 'r') {
+            t->ops[n].size = (size_t)strtoul(p, &p, 10);
+        }
+        else if (t->ops[n].type != 'f') {
+            munmap(text, st.st_size);
+            return -1;
+        }
+        if (t->ops[n].id < 0 || t->ops[n].id >= t->num_ids) {
+            munmap(text, st.st_size);
+            return -1;
+        }
+        n++;
+    }
+    munmap(text, st.st_size);
+    t->num_ops = n;
+    return 0;
+}
+
+// check_run : 블록 내용을 확인하며 한 번 재생하고 최대 사용률과 최대 힙 크기 계산
+static void check_run(trace_t* t, double* util, size_t* heap)
+{
+    char** ptr = calloc(t->num_ids, sizeof(char*)); // 번호별 블록
+    size_t* len = calloc(t->num_ids, sizeof(size_t)); // 번호별 요청 크기
+    size_t live = 0; // 살아 있는 페이로드 합
+    size_t peak = 0; // 그 최대값
+    size_t top = 0; // 힙 크기의 최대값 (mm_footprint 는 줄어들 수 있으므로 연산마다)
+    char* p;
+
+    mem_reset_brk();
+    if (mm_init() < 0) {
+        fail("mm_init failed", -1, -1);
+    }
+
+    for (int i = 0; i < t->num_ops; i++) {
+        op_t* o = &t->ops[i];
+        char fill = (char)(o->id * 7 + 1); // 번호마다 다른 내용
+
+        switch (o->type) {
+        case 'a':
+            if ((p = mm_malloc(o->size)) == NULL && o->size != 0) {
+                fail("mm_malloc returned NULL", i, o->id);
+            }
+            if ((size_t)p % ALIGNMENT != 0) {
+                fail("payload not aligned", i, o->id);
+            }
+            memset(p, fill, o->size);
+            ptr[o->id] = p;
+            len[o->id] = o->size;
+            live += o->size;
+            break;
+        case 'r':
+            if ((p = mm_realloc(ptr[o->id], o->size)) == NULL && o->size != 0) {
+                fail("mm_realloc returned NULL", i, o->id);
+            }
+            if ((size_t)p % ALIGNMENT != 0) {
+                fail("payload not aligned", i, o->id);
+            }
+            for (size_t k = 0; k < len[o->id] && k < o->size; k++) { // 앞부분 보존 확인
+                if (p[k] != fill) {
+                    fail("realloc lost payload", i, o->id);
+                }
+            }
+            memset(p, fill, o->size);
+            live += o->size - len[o->id];
+            ptr[o->id] = p;
+            len[o->id] = o->size;
+            break;
+        case 'f':
+            for (size_t k = 0; k < len[o->id]; k++) { // 다른 블록과 겹쳤으면 내용이 바뀜
+                if (ptr[o->id][k] != fill) {
+                    fail("payload overwritten", i, o->id);
+                }
+            }
+            mm_free(ptr[o->id]);
+            live -= len[o->id];
+            ptr[o->id] = NULL;
+            len[o->id] = 0;
+            break;
+        }
+        if (live > peak) {
+            peak = live;
+        }
+        if (footprint() > top) {
+            top = footprint();
+        }
+    }
+    *util = (top != 0) ? (double)peak / top : 0;
+    *heap = top;
+    free(ptr);
+    free(len);
+}
+
+// footprint : 변형이 OS 에서 받아 쓰는 바이트 (mm_footprint 가 없으면 mem_sbrk 힙 크기)
+static size_t footprint(void)
+{
+    return (mm_footprint != NULL) ? mm_footprint() : mem_heapsize();
+}
+
+// time_run : 검사 없이 MIN_TIME 이 넘을 때까지 반복 재생, 한 번 재생 평균 시간 (초)
+static double time_run(trace_t* t)
+{
+    void** ptr = calloc(t->num_ids, sizeof(void*));
+    double start = now_sec();
+    double elapsed;
+    int rounds = 0;
+
+    do {
+        mem_reset_brk();
+        mm_init();
+        for (int i = 0; i < t->num_ops; i++) {
+            op_t* o = &t->ops[i];
+
+            if (o->type == 'a') {
+                ptr[o->id] = mm_malloc(o->size);
+            }
+            else if (o->type == 'r') {
+                ptr[o->id] = mm_realloc(ptr[o->id], o->size);
+            }
+            else {
+                mm_free(ptr[o->id]);
+            }
+        }
+        rounds++;
+    } while ((elapsed = now_sec() - start) < MIN_TIME);
+
+    free(ptr);
+    return elapsed / rounds;
+}
+
+// now_sec : 단조 시계 (초)
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,315 @@
+// Binary Buddy - 2의 거듭제곱 블록, XOR 로 버디 찾기
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <sys/mman.h>
+#include <errno.h>
+
+#include "mm.h"
+#include "memlib.h"
+
+
+// 이미 있던 !
+#define ALIGNMENT 8
+#define ALIGN(size) (((size) + (ALIGNMENT-1)) & ~0x7)
+#define SIZE_T_SIZE (ALIGN(sizeof(size_t)))
+
+/////// 워드 / 더블 워드 / 힙 처음 크기
+#define WSIZE       4
+#define DSIZE       8
+#define CHUNKSIZE   (1 << 12)
+
+/////// 오더 (블록 크기 = 1 << order)
+#define MIN_ORDER   4           // 가장 작은 블록 16바이트 (헤더 + 프리 리스트 포인터 두 개)
+#define MAX_ORDER   31          // 헤더 한 워드에 담을 수 있는 가장 큰 블록
+
+#define MAX(x, y)   ((x) > (y) ? (x) : (y))
+
+// 정보 (블록 사이즈와 할당 여부를 헤더에 넣음, 풋터 없음)
+#define PACK(size, alloc)   ((size) | (alloc))
+
+#define GETTER(p)  (*(unsigned int *)(p))
+#define PUTTER(p, val)  (*(unsigned int *)(p) = (val))
+
+#define GET_SIZE(p)    (GETTER(p) & ~0x7)   // 블록 크기
+#define IS_ALLOCATED(p)   (GETTER(p) & 0x1)  // 블록 할당 여부
+
+// 블록 시작이 2의 거듭제곱 경계이므로 페이로드 정렬을 위해 헤더는 더블 워드 (뒤 워드는 비움)
+#define HDPT(bp)    ((char *)(bp) - DSIZE)  // 헤더 포인터
+
+// 버디 : heap_list 로부터의 오프셋에서 블록 크기 비트만 뒤집은 블록
+#define BUDDY(bp, size)   ((char *)heap_list + (((char *)(bp) - (char *)heap_list) ^ (size)))
+
+// 프리 블록 링크는 포인터 대신 첫 블록 헤더 ((char*)heap_list - DSIZE) 로부터 페이로드까지의 오프셋 / DSIZE 를 한 워드에
+// 페이로드는 헤더 더블 워드 뒤라 오프셋이 늘 DSIZE 이상이므로 0 은 NULL
+// 64비트에서도 최소 블록 16바이트 (헤더 더블 워드 + 이전/다음 링크 4바이트씩, 버디 블록은 풋터 없음) 그대로, 대신 힙은 32GB (2^32 * DSIZE) 까지
+#define TO_LINK(p)      ((p) == NULL ? 0u : (unsigned int)(((char*)(p) - ((char*)heap_list - DSIZE)) / DSIZE))
+#define FROM_LINK(v)    ((v) == 0 ? NULL : (void*)(((char*)heap_list - DSIZE) + (size_t)(v) * DSIZE))
+
+#define PRED_FREEPT(bp) FROM_LINK(GETTER(bp)) // 이전 프리블록 포인터
+#define SUCC_FREEPT(bp) FROM_LINK(GETTER((char*)(bp) + WSIZE)) // 다음 프리블록 포인터
+#define SET_PRED_FREEPT(bp, p)  PUTTER(bp, TO_LINK(p))
+#define SET_SUCC_FREEPT(bp, p)  PUTTER((char*)(bp) + WSIZE, TO_LINK(p))
+
+static void* heap_list = NULL; // 첫 블록의 페이로드 (버디 오프셋의 기준)
+static int heap_order; // 힙 전체 크기의 오더 (힙은 항상 2의 거듭제곱 크기)
+static void* order_list[MAX_ORDER + 1]; // 오더별 프리 리스트
+static unsigned int order_bitmap; // 비어있지 않은 오더 비트맵
+
+int mm_init(void);
+static int extend_heap(void);
+static void* coalesce(void* bp);
+void* mm_malloc(size_t size);
+static void* buddy_fit(int order);
+static void place(void* bp, int order);
+void mm_free(void* bp);
+void* mm_realloc(void* bp, size_t size);
+size_t mm_usable_size(void* bp);
+
+
+static int size_order(size_t size);
+static void remove_block(void* bp, int order);
+static void insert_block(void* bp, int order);
+
+// mm_init
+int mm_init(void)
+{
+    char* bp;
+
+    for (int i = 0; i <= MAX_ORDER; i++) { // 오더별 리스트 비우기
+        order_list[i] = NULL;
+    }
+    order_bitmap = 0;
+
+    // 메모리 확장 실패
+    if ((bp = mem_sbrk(CHUNKSIZE)) == (void*)-1) {
+        return -1;
+    }
+
+    heap_list = bp + DSIZE; // 첫 블록 페이로드
+    heap_order = size_order(CHUNKSIZE);
+
+    PUTTER(HDPT(heap_list), PACK(CHUNKSIZE, 0)); // 힙 전체가 프리 블록 하나
+    insert_block(heap_list, heap_order);
+    return 0;
+}
+
+// extend_heap : 힙을 두 배로 (새 영역은 지금 힙 전체의 버디)
+static int extend_heap(void) {
+    char* bp;
+    size_t size = (size_t)1 << heap_order; // 지금 힙 크기만큼 확장
+
+    if (heap_order >= MAX_ORDER) {
+        return -1;
+    }
+    // 힙 확장에 실패하면
+    if ((long)(bp = mem_sbrk(size)) == -1) {
+        return -1;
+    }
+
+    bp += DSIZE; // 새 블록 페이로드
+    PUTTER(HDPT(bp), PACK(size, 0)); // 프리 블록 헤더
+    heap_order++;
+
+    coalesce(bp); // 기존 힙 전체가 프리였다면 합쳐 !
+    return 0;
+}
+
+// coalesce : 버디가 같은 크기의 프리 블록이면 계속 합치기
+static void* coalesce(void* bp) {
+    size_t size = GET_SIZE(HDPT(bp)); // 현재 블록 크기
+    int order = size_order(size); // 현재 블록 오더
+    char* buddy; // 버디 블록
+
+    while (order < heap_order) {
+        buddy = BUDDY(bp, size);
+        // 버디가 쪼개져 있으면 같은 자리 헤더의 크기가 더 작으므로 합치지 않음
+        if (IS_ALLOCATED(HDPT(buddy)) || GET_SIZE(HDPT(buddy)) != size) {
+            break;
+        }
+        remove_block(buddy, order); // 버디 리스트에서 제거
+        if (buddy < (char*)bp) { // 합친 블록은 둘 중 앞쪽
+            bp = buddy;
+        }
+        size <<= 1;
+        order++;
+        PUTTER(HDPT(bp), PACK(size, 0)); // 합친 블록 헤더 갱신
+    }
+
+    insert_block(bp, order); // 합친 블록 리스트에 추가
+    return bp; // 합친 블록 반환
+}
+
+// mm_malloc
+void* mm_malloc(size_t size) {
+    int order; // 할당할 블록 오더
+    char* bp; // 찾은 프리 블록의 시작 주소
+
+    if (size == 0) { // 요청하는 크기가 0이면 할당 불필요
+        return NULL;
+    }
+
+    // 헤더를 위한 size + DSIZE 를 2의 거듭제곱으로 올림
+    order = size_order(size + DSIZE);
+    if (order > MAX_ORDER) {
+        return NULL;
+    }
+
+    // 적절한 프리 블록 탐색, 없으면 찾을 때까지 힙을 두 배로
+    while ((bp = buddy_fit(order)) == NULL) {
+        if (extend_heap() == -1) {
+            return NULL; // 실패하면 NULL
+        }
+    }
+    place(bp, order);  // 필요한 만큼 쪼개서 할당
+    return bp;  // 성공하면 블록 시작 주소 리턴
+}
+
+// buddy_fit : order 이상인 비어있지 않은 가장 작은 오더의 맨 앞 블록
+static void* buddy_fit(int order) {
+    unsigned int map = order_bitmap & (~0u << order); // order 이상 오더들
+
+    if (map == 0) {
+        return NULL; // 적합한 블록이 없을 경우 NULL 반환
+    }
+    return order_list[__builtin_ctz(map)];
+}
+
+// place : 블록을 반으로 쪼개며 뒤쪽 반은 프리 리스트에 (order 가 될 때까지)
+static void place(void* bp, int order) {
+    size_t size = GET_SIZE(HDPT(bp)); // 현재 블록 크기
+    int k = size_order(size); // 현재 블록 오더
+
+    remove_block(bp, k); // 할당할 블록이므로 리스트에서 제거
+
+    while (k > order) {
+        k--;
+        size >>= 1;
+        PUTTER(HDPT((char*)bp + size), PACK(size, 0)); // 뒤쪽 반 (버디) 프리 블록 헤더
+        insert_block((char*)bp + size, k);
+    }
+    PUTTER(HDPT(bp), PACK(size, 1)); // 블록 할당 헤더 설정
+}
+
+// mm_free
+void mm_free(void* bp)
+{
+    size_t size; // 블록 크기
+
+    if (bp == NULL) {
+        return;
+    }
+    size = GET_SIZE(HDPT(bp)); // 블록 해제를 위해 매개변수 받기
+
+    PUTTER(HDPT(bp), PACK(size, 0)); // 프리블록으로 상태 변경
+    coalesce(bp); // 버디와 병합
+}
+
+// mm_realloc : 줄일 때는 뒤쪽 반을 떼어 주고, 늘릴 때는 뒤쪽 버디가 통째로 프리면 제자리에서 합치기
+void* mm_realloc(void* bp, size_t size)
+{
+    void* old_bp = bp; // 기존 블록 포인터
+    void* new_bp;  // 새로 할당되는 블록 할당 포인터
+    size_t copySize; // 복사 데이터 크기
+    size_t c_size = GET_SIZE(HDPT(old_bp)); // 기존 블록 크기
+    size_t n_size; // 합쳐 가는 블록 크기
+    int order = size_order(size + DSIZE); // 새로 필요한 오더
+    int k = size_order(c_size); // 기존 오더
+
+    // 줄이기 : 뒤쪽 반(버디)을 계속 프리 리스트로, 버디의 짝은 할당 중이라 병합은 없음
+    if (order <= k) {
+        while (k > order) {
+            k--;
+            c_size >>= 1;
+            PUTTER(HDPT((char*)old_bp + c_size), PACK(c_size, 0));
+            insert_block((char*)old_bp + c_size, k);
+        }
+        PUTTER(HDPT(old_bp), PACK(c_size, 1));
+        return old_bp;
+    }
+
+    // 늘리기 : 오더마다 기존 블록이 앞쪽 반이고 뒤쪽 버디가 같은 크기 프리 블록인지 확인
+    for (n_size = c_size; k < order; k++, n_size <<= 1) {
+        if (k == heap_order && extend_heap() == -1) { // 힙 전체면 두 배로 늘려 새 반쪽을 버디로
+            break;
+        }
+        if (BUDDY(old_bp, n_size) < (char*)old_bp || IS_ALLOCATED(HDPT(BUDDY(old_bp, n_size)))
+            || GET_SIZE(HDPT(BUDDY(old_bp, n_size))) != n_size) {
+            break;
+        }
+    }
+    if (k == order) { // 모두 프리면 버디들을 리스트에서 빼고 합치기
+        for (n_size = c_size; n_size < ((size_t)1 << order); n_size <<= 1) {
+            remove_block(BUDDY(old_bp, n_size), size_order(n_size));
+        }
+        PUTTER(HDPT(old_bp), PACK(n_size, 1));
+        return old_bp;
+    }
+
+    new_bp = mm_malloc(size); // 새 블록 할당
+
+    if (new_bp == NULL) return NULL;
+
+    copySize = GET_SIZE(HDPT(old_bp)) - DSIZE; // 기존 블록 페이로드 크기
+
+    if (size < copySize) // 재할당할 크기가 기존보다 작으면
+        copySize = size; // 원래 size만큼조정
+
+    // 데이터 복사
+    memcpy(new_bp, old_bp, copySize);
+
+    mm_free(old_bp); // 기존 블록 해제
+
+    return new_bp; // 실패시 블록 할당 역할
+}
+
+// mm_usable_size : 블록 크기 - 더블 워드 헤더
+size_t mm_usable_size(void* bp)
+{
+    if (bp == NULL) {
+        return 0;
+    }
+    return GET_SIZE(HDPT(bp)) - DSIZE;
+}
+
+// size_order : size 이상인 가장 작은 2의 거듭제곱의 오더 (MIN_ORDER 이상)
+static int size_order(size_t size) {
+    int order;
+
+    if (size <= ((size_t)1 << MIN_ORDER)) {
+        return MIN_ORDER;
+    }
+    order = 64 - __builtin_clzll((unsigned long long)size - 1); // ceil(log2(size))
+    return order;
+}
+
+// remove_block
+static void remove_block(void* bp, int order) {
+    if (SUCC_FREEPT(bp) != NULL) { // 다음 블록이 존재하는 경우
+        SET_PRED_FREEPT(SUCC_FREEPT(bp), PRED_FREEPT(bp)); // 이전 블록 연결 갱신
+    }
+    if (PRED_FREEPT(bp) != NULL) { // 이전 블록이 존재하는 경우
+        SET_SUCC_FREEPT(PRED_FREEPT(bp), SUCC_FREEPT(bp)); // 다음 블록 연결 갱신
+    }
+    else { // 현재 블록이 리스트의 첫 블록인 경우
+        order_list[order] = SUCC_FREEPT(bp); // 리스트 헤더 갱신
+        if (order_list[order] == NULL) { // 리스트가 비면 비트맵에서 지우기
+            order_bitmap &= ~(1u << order);
+        }
+    }
+}
+
+// insert_block : 오더 리스트 맨 앞에 추가
+static void insert_block(void* bp, int order) {
+    SET_SUCC_FREEPT(bp, order_list[order]);
+    SET_PRED_FREEPT(bp, NULL);
+    if (order_list[order] != NULL) {
+        SET_PRED_FREEPT(order_list[order], bp);
+    }
+    order_list[order] = bp;
+    order_bitmap |= 1u << order; // 비어있지 않은 오더로 표시
+}
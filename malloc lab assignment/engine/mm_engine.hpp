@@ -0,0 +1,552 @@
+// mm_engine.hpp : 정책을 템플릿 인자로 받아 조립하는 할당기 엔진 (헤더 전용, C++17)
+//
+//   allocator<Index, Fit, Layout>
+//     Index  : 프리 블록 관리  - implicit_list / explicit_list / segregated_list
+//     Fit    : 탐색 정책       - first_fit / next_fit / best_fit / worst_fit
+//     Layout : 블록 모양       - layout<헤더 워드, 정렬, 할당 블록 풋터 생략>
+//   정책은 전부 컴파일 타임에 골라지고 (인라인 + if constexpr) 런타임 분기는 없음
+//
+//   MM_ENGINE(allocator<...>) 한 줄이면 그 조합으로 mm_init / mm_malloc / mm_free / mm_realloc 정의
+//   기존 변형과의 대응은 블록 모양, 탐색 정책, 프리 블록을 담는 리스트 종류까지만 (같은 할당기가 아님)
+//     mm_1 ~ mm_4  : allocator<implicit_list, first_fit / next_fit / best_fit / worst_fit>
+//     mm_5 ~ mm_7  : allocator<explicit_list, first_fit / best_fit / worst_fit>
+//     mm_8 ~ mm_10 : allocator<segregated_list, first_fit / best_fit / worst_fit>
+//   엔진 리스트는 모두 LIFO 라 넣을 때 크기순 / 주소순 정렬이 없고 (mm_8 클래스 리스트는 크기순),
+//   칸 세그먼트 트리, red-black 트리, 최대 힙, quick list, tcache, 아레나, slab, mmap 블록 같은 가속 구조도 없음
+//   -> 탐색은 리스트 (implicit 은 힙 전체) 를 걷는 O(n), 같은 정책의 C 변형보다 느리고 사용률도 다를 수 있음
+//
+// 블록 (W = 헤더 워드 바이트)
+//   헤더 : PACK(size, alloc) | PREV_ALLOC, 프리 블록은 맨 끝 워드에 풋터 (헤더 복사본)
+//   풋터 생략이면 할당 블록은 풋터 없이 다음 블록 헤더의 PREV_ALLOC 으로 표시 (기존 변형들과 같음)
+//   프리 리스트 링크는 heap_base 로부터의 오프셋을 헤더 워드 폭으로 저장 (0 이 NULL)
+//     -> 4바이트 헤더면 64비트에서도 최소 블록 16바이트, 힙은 4GB 까지
+
+#ifndef MM_ENGINE_HPP
+#define MM_ENGINE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "mm.h"
+#include "memlib.h"
+
+namespace mm {
+
+// layout : 헤더 워드 폭 / 페이로드 정렬 / 할당 블록 풋터 생략 여부
+template <class Word = std::uint32_t, std::size_t Align = 8, bool ElideFooter = true>
+struct layout {
+    using word = Word;
+
+    static constexpr std::size_t WSIZE = sizeof(Word);  // 헤더, 풋터, 링크 한 칸
+    static constexpr std::size_t ALIGNMENT = Align;     // 페이로드 정렬
+    static constexpr bool ELIDE_FOOTER = ElideFooter;   // 할당 블록 풋터 생략
+
+    static_assert((Align & (Align - 1)) == 0 && Align >= 8 && Align >= WSIZE, "정렬은 8 이상의 2의 거듭제곱, 헤더 워드 이상");
+
+    static constexpr Word ALLOC = 0x1;       // 할당 비트
+    static constexpr Word PREV_ALLOC = 0x2;  // 앞 블록 할당 비트
+
+    static inline char* heap_base = nullptr; // 링크 오프셋 기준 (mm_init 이 설정)
+
+    static constexpr std::size_t align(std::size_t n) { return (n + Align - 1) & ~(Align - 1); }
+
+    static Word get(const char* p) { return *(const Word*)p; }
+    static void put(char* p, Word val) { *(Word*)p = val; }
+
+    static char* hdpt(char* bp) { return bp - WSIZE; }                          // 헤더 포인터
+    static char* ftpt(char* bp) { return bp + size(bp) - 2 * WSIZE; }           // 풋터 포인터
+    static std::size_t size(char* bp) { return get(hdpt(bp)) & ~(Word)0x7; }    // 블록 크기
+    static bool allocated(char* bp) { return get(hdpt(bp)) & ALLOC; }           // 할당 여부
+    static bool prev_allocated(char* bp) { return get(hdpt(bp)) & PREV_ALLOC; } // 앞 블록 할당 여부
+    static char* next(char* bp) { return bp + size(bp); }                       // 다음 블록
+    static char* prev(char* bp) { return bp - (get(bp - 2 * WSIZE) & ~(Word)0x7); } // 앞 블록 (앞 블록 풋터 필요)
+
+    // 헤더 쓰기 (PREV_ALLOC 비트는 그대로)
+    static void set_header(char* bp, std::size_t size, Word alloc) {
+        put(hdpt(bp), (Word)size | alloc | (get(hdpt(bp)) & PREV_ALLOC));
+    }
+    // 프리 블록 헤더와 풋터
+    static void set_free(char* bp, std::size_t size) {
+        set_header(bp, size, 0);
+        put(ftpt(bp), (Word)size);
+    }
+    // 할당 블록 헤더 (풋터 생략이 아니면 풋터도)
+    static void set_allocated(char* bp, std::size_t size) {
+        set_header(bp, size, ALLOC);
+        if constexpr (!ElideFooter) {
+            put(ftpt(bp), (Word)size | ALLOC);
+        }
+    }
+    // 다음 블록 헤더에 이 블록 할당 여부 표시
+    static void mark_next(char* bp, bool alloc) {
+        if constexpr (ElideFooter) {
+            char* hp = hdpt(next(bp));
+            put(hp, alloc ? (get(hp) | PREV_ALLOC) : (get(hp) & ~PREV_ALLOC));
+        }
+    }
+
+    // 프리 리스트 링크 (i 번째 워드, 오프셋 0 이 NULL)
+    static char* link(char* bp, int i) {
+        Word off = get(bp + i * WSIZE);
+        return off ? heap_base + off : nullptr;
+    }
+    static void set_link(char* bp, int i, char* p) {
+        put(bp + i * WSIZE, p ? (Word)(p - heap_base) : 0);
+    }
+};
+
+/////// 탐색 정책
+//   offer 로 후보를 하나씩 받아 better 면 바꾸고, done 이면 탐색 끝
+//   NEXT : 지난번 찾은 곳(rover)부터 탐색 / DESCENDING : 분리 리스트를 큰 클래스부터
+struct first_fit {
+    static constexpr bool NEXT = false;
+    static constexpr bool DESCENDING = false;
+    static bool better(std::size_t, std::size_t) { return false; }
+    static bool done(std::size_t, std::size_t) { return true; }
+};
+
+struct next_fit {
+    static constexpr bool NEXT = true;
+    static constexpr bool DESCENDING = false;
+    static bool better(std::size_t, std::size_t) { return false; }
+    static bool done(std::size_t, std::size_t) { return true; }
+};
+
+struct best_fit {
+    static constexpr bool NEXT = false;
+    static constexpr bool DESCENDING = false;
+    static bool better(std::size_t size, std::size_t best) { return size < best; }
+    static bool done(std::size_t size, std::size_t a_size) { return size == a_size; } // 딱 맞으면 끝
+};
+
+struct worst_fit {
+    static constexpr bool NEXT = false;
+    static constexpr bool DESCENDING = true;
+    static bool better(std::size_t size, std::size_t best) { return size > best; }
+    static bool done(std::size_t, std::size_t) { return false; }
+};
+
+// fit_state : 탐색 중 지금까지 고른 블록
+template <class L, class Fit>
+struct fit_state {
+    char* bp = nullptr;
+    std::size_t size = 0;
+
+    // offer : 후보 하나 받기, 탐색을 끝내도 되면 true
+    bool offer(char* cand, std::size_t a_size) {
+        std::size_t c_size = L::size(cand);
+
+        if (c_size < a_size) {
+            return false;
+        }
+        if (bp == nullptr || Fit::better(c_size, size)) {
+            bp = cand;
+            size = c_size;
+        }
+        return Fit::done(c_size, a_size);
+    }
+};
+
+/////// 프리 블록 관리
+//   reset(heap_list) / insert(bp) / remove(bp) / absorb(bp, next) / find(a_size)
+//   absorb : 프리 블록 next 가 바로 앞 블록 bp 에 합쳐져 없어짐
+//   LINKS : 프리 블록 페이로드에 필요한 링크 워드 수 (최소 블록 크기 결정)
+
+// implicit_list : 힙 전체를 블록 단위로 걷기 (mm_1 ~ mm_4 의 칸 인덱스 / 최대 힙 없이)
+template <class L, class Fit>
+class implicit_list {
+    char* heap_list = nullptr; // 프롤로그 블록
+    char* rover = nullptr; // next fit 탐색 시작점
+
+public:
+    static constexpr std::size_t LINKS = 0;
+
+    void reset(char* bp) { heap_list = rover = bp; }
+
+    void insert(char* bp) {
+        if constexpr (Fit::NEXT) {
+            rover = bp; // 합쳐진 블록부터 (mm_2 와 같음)
+        }
+    }
+    void remove(char*) {}
+    void absorb(char* bp, char* next) {
+        if constexpr (Fit::NEXT) {
+            if (rover == next) { // 없어지는 블록을 가리키던 탐색 시작점 옮기기
+                rover = bp;
+            }
+        }
+    }
+
+    char* find(std::size_t a_size) {
+        fit_state<L, Fit> f;
+        char* start = Fit::NEXT ? rover : heap_list;
+        char* bp;
+
+        for (bp = start; L::size(bp) > 0; bp = L::next(bp)) { // 에필로그까지
+            if (!L::allocated(bp) && f.offer(bp, a_size)) {
+                break;
+            }
+        }
+        if constexpr (Fit::NEXT) {
+            if (f.bp == nullptr) { // 못 찾았으면 처음부터 시작점까지
+                for (bp = heap_list; bp < start; bp = L::next(bp)) {
+                    if (!L::allocated(bp) && f.offer(bp, a_size)) {
+                        break;
+                    }
+                }
+            }
+            if (f.bp != nullptr) {
+                rover = f.bp;
+            }
+        }
+        return f.bp;
+    }
+};
+
+// free_list : LIFO 이중 연결 프리 리스트 하나 (링크 0 = PRED, 1 = SUCC)
+template <class L, class Fit>
+struct free_list {
+    char* head = nullptr;
+    char* rover = nullptr; // next fit 탐색 시작점
+
+    void insert(char* bp) {
+        L::set_link(bp, 0, nullptr);
+        L::set_link(bp, 1, head);
+        if (head != nullptr) {
+            L::set_link(head, 0, bp);
+        }
+        head = bp;
+    }
+
+    void remove(char* bp) {
+        char* pred = L::link(bp, 0);
+        char* succ = L::link(bp, 1);
+
+        if constexpr (Fit::NEXT) {
+            if (rover == bp) { // 빠지는 블록을 가리키던 탐색 시작점은 다음 블록으로
+                rover = succ;
+            }
+        }
+        if (succ != nullptr) {
+            L::set_link(succ, 0, pred);
+        }
+        if (pred != nullptr) {
+            L::set_link(pred, 1, succ);
+        }
+        else {
+            head = succ;
+        }
+    }
+
+    void scan(fit_state<L, Fit>& f, std::size_t a_size) {
+        char* start = (Fit::NEXT && rover != nullptr) ? rover : head;
+        char* bp;
+
+        for (bp = start; bp != nullptr; bp = L::link(bp, 1)) {
+            if (f.offer(bp, a_size)) {
+                break;
+            }
+        }
+        if constexpr (Fit::NEXT) {
+            if (f.bp == nullptr) { // 못 찾았으면 맨 앞부터 시작점까지
+                for (bp = head; bp != start; bp = L::link(bp, 1)) {
+                    if (f.offer(bp, a_size)) {
+                        break;
+                    }
+                }
+            }
+            if (f.bp != nullptr) {
+                rover = f.bp;
+            }
+        }
+    }
+};
+
+// explicit_list : 프리 블록만 LIFO 리스트 하나로 (mm_6 트리, mm_7 최대 힙 없이)
+template <class L, class Fit>
+class explicit_list {
+    free_list<L, Fit> list;
+
+public:
+    static constexpr std::size_t LINKS = 2;
+
+    void reset(char*) { list = free_list<L, Fit>(); }
+    void insert(char* bp) { list.insert(bp); }
+    void remove(char* bp) { list.remove(bp); }
+    void absorb(char*, char* next) { list.remove(next); }
+
+    char* find(std::size_t a_size) {
+        fit_state<L, Fit> f;
+
+        list.scan(f, a_size);
+        return f.bp;
+    }
+};
+
+// segregated_list : floor(log2(size)) 크기 클래스별 LIFO 리스트 + 비어있지 않은 클래스 비트맵 (mm_9 트리, mm_10 최대 힙 없이)
+//   요청 클래스부터 (worst fit 은 가장 큰 클래스부터) 맞는 블록이 있는 첫 클래스에서 정책대로 고름
+template <class L, class Fit>
+class segregated_list {
+    static constexpr int LISTLIMIT = 20; // 크기 클래스 수
+
+    free_list<L, Fit> lists[LISTLIMIT];
+    std::uint32_t bitmap = 0;
+
+    static int list_index(std::size_t size) {
+        int i = 63 - __builtin_clzll((unsigned long long)size | 1); // floor(log2(size))
+
+        return (i < LISTLIMIT - 1) ? i : LISTLIMIT - 1; // 큰 블록은 마지막 리스트로
+    }
+
+public:
+    static constexpr std::size_t LINKS = 2;
+
+    void reset(char*) {
+        for (int i = 0; i < LISTLIMIT; i++) {
+            lists[i] = free_list<L, Fit>();
+        }
+        bitmap = 0;
+    }
+
+    void insert(char* bp) {
+        int i = list_index(L::size(bp));
+
+        lists[i].insert(bp);
+        bitmap |= 1u << i;
+    }
+
+    void remove(char* bp) {
+        int i = list_index(L::size(bp));
+
+        lists[i].remove(bp);
+        if (lists[i].head == nullptr) {
+            bitmap &= ~(1u << i);
+        }
+    }
+
+    void absorb(char*, char* next) { remove(next); }
+
+    char* find(std::size_t a_size) {
+        fit_state<L, Fit> f;
+        std::uint32_t map = bitmap & (~0u << list_index(a_size)); // 요청 클래스 이상
+        int i;
+
+        while (map != 0) {
+            i = Fit::DESCENDING ? 31 - __builtin_clz(map) : __builtin_ctz(map);
+            lists[i].scan(f, a_size);
+            if (f.bp != nullptr) {
+                return f.bp;
+            }
+            map &= ~(1u << i);
+        }
+        return nullptr;
+    }
+};
+
+/////// 엔진
+template <template <class, class> class Index, class Fit, class Layout = layout<>>
+class allocator {
+    using L = Layout;
+    using word = typename L::word;
+
+    static constexpr std::size_t WSIZE = L::WSIZE;
+    static constexpr std::size_t OVERHEAD = L::ELIDE_FOOTER ? WSIZE : 2 * WSIZE; // 할당 블록 헤더 (+ 풋터)
+    static constexpr std::size_t MIN_BLOCK = L::align((2 + Index<L, Fit>::LINKS) * WSIZE); // 헤더 + 링크 + 풋터
+    static constexpr std::size_t PROLOGUE = L::align(2 * WSIZE); // 프롤로그 블록 크기
+    static constexpr std::size_t CHUNKSIZE = 1 << 12;
+
+    char* heap_list = nullptr; // 프롤로그 블록
+    Index<L, Fit> index;
+
+    // a_size : 요청 크기를 헤더 포함 정렬된 블록 크기로
+    static std::size_t a_size(std::size_t size) {
+        std::size_t a = L::align(size + OVERHEAD);
+
+        return a < MIN_BLOCK ? MIN_BLOCK : a;
+    }
+
+    // extend_heap : size 바이트 프리 블록으로 힙 확장 (에필로그 자리가 새 블록 헤더)
+    char* extend_heap(std::size_t size) {
+        char* bp;
+
+        size = L::align(size);
+        if ((bp = (char*)mem_sbrk((int)size)) == (char*)-1) {
+            return nullptr;
+        }
+        L::set_free(bp, size);                  // PREV_ALLOC 은 옛 에필로그 것 그대로
+        L::put(L::hdpt(L::next(bp)), L::ALLOC); // 새 에필로그
+        return coalesce(bp);
+    }
+
+    // coalesce : 앞뒤 프리 블록과 병합하고 인덱스에 추가
+    char* coalesce(char* bp) {
+        std::size_t size = L::size(bp);
+        char* next = L::next(bp);
+        bool prev_alloc;
+
+        if constexpr (L::ELIDE_FOOTER) {
+            prev_alloc = L::prev_allocated(bp);
+        }
+        else {
+            prev_alloc = L::allocated(L::prev(bp));
+        }
+
+        if (!L::allocated(next)) { // 다음이 프리블록이면
+            index.absorb(bp, next);
+            size += L::size(next);
+        }
+        if (!prev_alloc) { // 이전이 프리블록이면
+            bp = L::prev(bp);
+            index.remove(bp);
+            size += L::size(bp);
+        }
+        L::set_free(bp, size);
+        index.insert(bp);
+        return bp;
+    }
+
+    // place : 프리 블록 bp 에 a_size 할당, 남는 부분이 최소 블록 이상이면 분할
+    void place(char* bp, std::size_t a_size) {
+        std::size_t c_size = L::size(bp);
+
+        index.remove(bp);
+        if (c_size - a_size >= MIN_BLOCK) {
+            L::set_allocated(bp, a_size);
+            bp = L::next(bp);
+            L::put(L::hdpt(bp), L::PREV_ALLOC); // 나머지 프리 블록 (앞은 할당)
+            L::set_free(bp, c_size - a_size);
+            index.insert(bp);
+        }
+        else {
+            L::set_allocated(bp, c_size);
+            L::mark_next(bp, true);
+        }
+    }
+
+    // shrink : 할당 블록 bp (c_size) 를 a_size 로 줄이고 나머지는 프리 블록으로
+    void shrink(char* bp, std::size_t c_size, std::size_t a_size) {
+        if (c_size - a_size >= MIN_BLOCK) {
+            L::set_allocated(bp, a_size);
+            bp = L::next(bp);
+            L::put(L::hdpt(bp), L::PREV_ALLOC);
+            L::set_free(bp, c_size - a_size);
+            L::mark_next(bp, false);
+            coalesce(bp); // 다음 블록이 프리면 합치기
+        }
+        else {
+            L::set_allocated(bp, c_size);
+            L::mark_next(bp, true);
+        }
+    }
+
+public:
+    int init() {
+        char* p;
+
+        if ((p = (char*)mem_sbrk((int)(L::ALIGNMENT + PROLOGUE))) == (char*)-1) {
+            return -1;
+        }
+        L::heap_base = p;
+        heap_list = p + L::ALIGNMENT; // 프롤로그 페이로드 (정렬된 자리)
+        L::put(L::hdpt(heap_list), (word)PROLOGUE | L::ALLOC | L::PREV_ALLOC); // 프롤로그 헤더
+        L::put(L::ftpt(heap_list), (word)PROLOGUE | L::ALLOC);                 // 프롤로그 풋터
+        L::put(L::hdpt(L::next(heap_list)), L::ALLOC | L::PREV_ALLOC);         // 에필로그
+        index.reset(heap_list);
+
+        if (extend_heap(CHUNKSIZE) == nullptr) {
+            return -1;
+        }
+        return 0;
+    }
+
+    void* malloc(std::size_t size) {
+        std::size_t a = a_size(size);
+        char* bp;
+
+        if (size == 0) {
+            return nullptr;
+        }
+        if ((bp = index.find(a)) == nullptr) { // 못 찾으면 힙 확장
+            if ((bp = extend_heap(a > CHUNKSIZE ? a : CHUNKSIZE)) == nullptr) {
+                return nullptr;
+            }
+        }
+        place(bp, a);
+        return bp;
+    }
+
+    void free(void* ptr) {
+        char* bp = (char*)ptr;
+
+        if (bp == nullptr) {
+            return;
+        }
+        L::set_free(bp, L::size(bp));
+        L::mark_next(bp, false);
+        coalesce(bp);
+    }
+
+    // realloc : 줄이면 제자리 분할, 늘리면 다음 프리 블록이나 힙 끝을 붙여 제자리, 안 되면 새로 할당 후 복사
+    void* realloc(void* ptr, std::size_t size) {
+        char* bp = (char*)ptr;
+        char* next;
+        char* new_bp;
+        std::size_t a, c_size, copy_size;
+
+        if (bp == nullptr) {
+            return malloc(size);
+        }
+        if (size == 0) {
+            free(bp);
+            return nullptr;
+        }
+        a = a_size(size);
+        c_size = L::size(bp);
+        if (a <= c_size) {
+            shrink(bp, c_size, a);
+            return bp;
+        }
+
+        next = L::next(bp);
+        if (!L::allocated(next) && c_size + L::size(next) >= a) { // 다음 프리 블록 붙이기
+            index.absorb(bp, next);
+            c_size += L::size(next);
+            L::set_allocated(bp, c_size);
+            shrink(bp, c_size, a);
+            return bp;
+        }
+        if (L::size(next) == 0) { // 힙 끝 블록이면 모자란 만큼만 힙 확장
+            std::size_t incr = L::align(a - c_size);
+
+            if (mem_sbrk((int)incr) != (void*)-1) {
+                L::set_allocated(bp, c_size + incr);
+                L::put(L::hdpt(L::next(bp)), L::ALLOC | L::PREV_ALLOC); // 새 에필로그
+                return bp;
+            }
+        }
+
+        if ((new_bp = (char*)malloc(size)) == nullptr) {
+            return nullptr;
+        }
+        copy_size = c_size - OVERHEAD; // 기존 페이로드 크기
+        if (size < copy_size) {
+            copy_size = size;
+        }
+        std::memcpy(new_bp, bp, copy_size);
+        free(bp);
+        return new_bp;
+    }
+};
+
+} // namespace mm
+
+// MM_ENGINE : 조합 하나로 mm.h 인터페이스 정의 (번역 단위 하나에 한 번)
+#define MM_ENGINE(...)                                                                      \
+    static __VA_ARGS__ mm_engine;                                                           \
+    extern "C" int mm_init(void) { mm_engine = __VA_ARGS__(); return mm_engine.init(); }    \
+    extern "C" void* mm_malloc(size_t size) { return mm_engine.malloc(size); }              \
+    extern "C" void mm_free(void* ptr) { mm_engine.free(ptr); }                             \
+    extern "C" void* mm_realloc(void* ptr, size_t size) { return mm_engine.realloc(ptr, size); }
+
+#endif
@@ -0,0 +1,5 @@
+// mm_6 과 같은 탐색 정책 (best fit) 을 LIFO 리스트 하나로 - mm_6 의 (크기, 주소) red-black 트리와 quick list 는 없음
+
+#include "mm_engine.hpp"
+
+MM_ENGINE(mm::allocator<mm::explicit_list, mm::best_fit>)
@@ -0,0 +1,5 @@
+// 새 조합 : 명시적 리스트 best fit, 할당 블록에도 풋터 (CS:APP 원래 모양)
+
+#include "mm_engine.hpp"
+
+MM_ENGINE(mm::allocator<mm::explicit_list, mm::best_fit, mm::layout<std::uint32_t, 8, false>>)
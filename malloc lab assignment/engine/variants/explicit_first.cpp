@@ -0,0 +1,5 @@
+// mm_5 와 같은 리스트 / 탐색 정책 (LIFO 리스트 하나, first fit - mm_5 의 quick list 와 주소순 빌드 옵션은 없음)
+
+#include "mm_engine.hpp"
+
+MM_ENGINE(mm::allocator<mm::explicit_list, mm::first_fit>)
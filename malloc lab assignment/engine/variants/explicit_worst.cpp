@@ -0,0 +1,5 @@
+// mm_7 과 같은 탐색 정책 (worst fit) 을 LIFO 리스트 하나로 - mm_7 의 최대 힙과 quick list 는 없음
+
+#include "mm_engine.hpp"
+
+MM_ENGINE(mm::allocator<mm::explicit_list, mm::worst_fit>)
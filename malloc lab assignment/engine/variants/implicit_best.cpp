@@ -0,0 +1,5 @@
+// mm_3 과 같은 탐색 정책 (best fit, 힙 전체를 걸음 - mm_3 의 크기 클래스 비트맵 트리와 quick list 는 없음)
+
+#include "mm_engine.hpp"
+
+MM_ENGINE(mm::allocator<mm::implicit_list, mm::best_fit>)
@@ -0,0 +1,5 @@
+// mm_1 과 같은 탐색 정책 (first fit, 힙 전체를 걸음 - mm_1 의 칸 세그먼트 트리와 quick list 는 없음)
+
+#include "mm_engine.hpp"
+
+MM_ENGINE(mm::allocator<mm::implicit_list, mm::first_fit>)
@@ -0,0 +1,5 @@
+// mm_2 와 같은 탐색 정책 (next fit, rover 부터 힙을 걸음 - mm_2 의 칸 세그먼트 트리와 quick list 는 없음)
+
+#include "mm_engine.hpp"
+
+MM_ENGINE(mm::allocator<mm::implicit_list, mm::next_fit>)
@@ -0,0 +1,5 @@
+// mm_4 와 같은 탐색 정책 (worst fit, 힙 전체를 걸음 - mm_4 의 최대 힙과 quick list 는 없음)
+
+#include "mm_engine.hpp"
+
+MM_ENGINE(mm::allocator<mm::implicit_list, mm::worst_fit>)
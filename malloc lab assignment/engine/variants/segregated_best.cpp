@@ -0,0 +1,5 @@
+// mm_9 와 같은 탐색 정책 (best fit) 을 log2 클래스 LIFO 리스트로 - mm_9 의 정확한 크기 리스트, red-black 트리, quick list 는 없음
+
+#include "mm_engine.hpp"
+
+MM_ENGINE(mm::allocator<mm::segregated_list, mm::best_fit>)
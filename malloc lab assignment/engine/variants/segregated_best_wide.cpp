@@ -0,0 +1,5 @@
+// 새 조합 : 분리 리스트 best fit, 8바이트 헤더 + 16바이트 정렬
+
+#include "mm_engine.hpp"
+
+MM_ENGINE(mm::allocator<mm::segregated_list, mm::best_fit, mm::layout<std::uint64_t, 16>>)
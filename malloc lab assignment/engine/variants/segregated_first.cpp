@@ -0,0 +1,5 @@
+// mm_8 과 같은 탐색 정책 (클래스별 first fit) 을 LIFO 리스트로 - mm_8 의 크기순 삽입, tcache, 아레나, slab, mmap 블록은 없음
+
+#include "mm_engine.hpp"
+
+MM_ENGINE(mm::allocator<mm::segregated_list, mm::first_fit>)
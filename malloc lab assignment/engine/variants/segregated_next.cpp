@@ -0,0 +1,5 @@
+// 새 조합 : 분리 리스트 + 클래스별 next fit
+
+#include "mm_engine.hpp"
+
+MM_ENGINE(mm::allocator<mm::segregated_list, mm::next_fit>)
@@ -0,0 +1,5 @@
+// mm_10 과 같은 탐색 정책 (가장 큰 클래스에서 worst fit) 을 LIFO 리스트로 - mm_10 의 클래스별 최대 힙과 quick list 는 없음
+
+#include "mm_engine.hpp"
+
+MM_ENGINE(mm::allocator<mm::segregated_list, mm::worst_fit>)
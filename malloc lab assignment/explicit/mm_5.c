@@ -1,4 +1,8 @@
 // Explicit Linked List - First fit
+// + 빌드 옵션 -DNEXT_FIT : 지난번에 찾은 블록 다음(rover)부터 탐색하는 next fit
+// + 빌드 옵션 -DADDRESS_ORDERED : LIFO 대신 주소순 리스트 (칸별 첫 블록 인덱스로 넣을 자리 찾기)
+
+#define _GNU_SOURCE // mremap
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -24,6 +28,13 @@
 
 #define MAX(x, y)   ((x) > (y) ? (x) : (y))   
 
+/////// quick list : 최근 해제된 작은 블록을 병합 없이 크기별로 모아 두었다가 같은 크기 요청에 바로 재사용
+#define QUICK_MAX   64                      // quick list 로 처리하는 최대 블록 크기
+#define QUICK_LISTS (QUICK_MAX / DSIZE + 1) // 블록 크기 / DSIZE 가 리스트 번호 (정확히 같은 크기만)
+#define QUICK_LIMIT 128                     // 모인 블록 수가 이보다 많아지면 전부 병합 (consolidate)
+
+#define QUICK_NEXT(bp) (*(void**)(bp)) // quick list 안 다음 블록 (할당 상태 블록의 페이로드 첫 칸)
+
 // 정보 (블록 사이즈와 할당 여부에 대한 정보를 헤더와 풋터에 넣어야 함)
 #define PACK(size, alloc)   ((size) | (alloc))
 
@@ -32,6 +43,11 @@
 
 #define GET_SIZE(p)    (GETTER(p) & ~0x7)   // 블록 크기
 #define IS_ALLOCATED(p)   (GETTER(p) & 0x1)  // 블록 할당 여부
+#define IS_PREV_ALLOCATED(p)   (GETTER(p) & 0x2)   // 이전 블록 할당 여부 (헤더에만 기록)
+#define PREV_ALLOC  0x2   // 헤더의 이전 블록 할당 비트
+
+#define SET_PREV_ALLOC(p)   PUTTER(p, GETTER(p) | PREV_ALLOC)   // 이전 블록 할당 표시
+#define CLR_PREV_ALLOC(p)   PUTTER(p, GETTER(p) & ~PREV_ALLOC)  // 이전 블록 프리 표시
 
 #define HDPT(bp)    ((char *)(bp) - WSIZE)  // 헤더 포인터
 #define FTPT(bp)    ((char *)(bp) + GET_SIZE(HDPT(bp)) - DSIZE)  // 풋터 포인터
@@ -39,28 +55,68 @@
 #define NEXT_BLKP(bp)   (((char *)(bp) + GET_SIZE((char *)(bp) - WSIZE)))   // 다음 블록 포인터 
 #define PREV_BLKP(bp)   (((char *)(bp) - GET_SIZE((char *)(bp) - DSIZE)))   // 이전 블록 포인터
 
-#define PRED_FREEPT(bp) (*(void**)(bp)) // 이전 프리블록 포인터
-#define SUCC_FREEPT(bp) (*(void**)(bp + WSIZE)) // 다음 프리블록 포인터
+// 프리 블록 링크는 포인터 대신 heap_list 로부터의 오프셋 / DSIZE 를 한 워드에 (0 은 NULL)
+// 64비트에서도 최소 블록 16바이트 (헤더 + 이전 + 다음 + 풋터) 그대로, 대신 힙은 heap_list 부터 32GB (2^32 * DSIZE) 까지
+#define TO_LINK(p)      ((p) == NULL ? 0u : (unsigned int)(((char*)(p) - (char*)heap_list) / DSIZE))
+#define FROM_LINK(v)    ((v) == 0 ? NULL : (void*)((char*)heap_list + (size_t)(v) * DSIZE))
+
+#define PRED_FREEPT(bp) FROM_LINK(GETTER(bp)) // 이전 프리블록 포인터
+#define SUCC_FREEPT(bp) FROM_LINK(GETTER((char*)(bp) + WSIZE)) // 다음 프리블록 포인터
+#define SET_PRED_FREEPT(bp, p)  PUTTER(bp, TO_LINK(p))
+#define SET_SUCC_FREEPT(bp, p)  PUTTER((char*)(bp) + WSIZE, TO_LINK(p))
+
+/////// 주소순 리스트 (-DADDRESS_ORDERED)
+// 힙을 REGION_SIZE 칸으로 나눠 칸마다 주소가 가장 작은 프리 블록을 기억해 두고,
+// 넣을 때는 같은 칸(없으면 앞쪽으로 가장 가까운 칸)의 첫 블록부터 걸어서 자리를 찾음 (리스트 전체를 걷지 않음)
+#define REGION_SHIFT    12                      // 칸 크기 4KB
+#define REGION_MIN      1024                    // 인덱스 배열 처음 칸 수 (모자라면 두 배씩 mremap)
+#define REGION_OF(bp)   ((size_t)((char*)(bp) - (char*)mem_heap_lo()) >> REGION_SHIFT)   // 블록이 속한 칸
+// 앞쪽으로 가장 가까운 칸은 두 단계 비트맵에서 clz 로 (칸 하나씩 거꾸로 걷지 않음)
+#define BIT(n)          (1ull << ((n) & 63))    // 64비트 워드 안 n 번 비트
 
 static void* heap_list = NULL; // 힙 리스트 시작 포인터
+static void* quick_list[QUICK_LISTS]; // 크기별 quick list (LIFO)
+static int quick_count; // quick list 에 모인 블록 수
 static void* free_list = NULL; // 프리블록 리스트 시작 포인터
-
-static int mm_init(void);
+#ifdef NEXT_FIT
+static void* rover; // next fit 탐색 시작 블록 (리스트 끝 센티넬이면 처음부터)
+#endif
+#ifdef ADDRESS_ORDERED
+static void** region_first; // 칸별 주소가 가장 작은 프리 블록 (mmap, mm_init 이 다시 불려도 재사용)
+static size_t region_cap; // 인덱스 배열 칸 수
+static unsigned long long* region_bits; // 칸 64개마다 한 워드, 첫 블록이 있는 칸 비트
+static unsigned long long* region_sum; // region_bits 워드 64개마다 한 워드, 0 이 아닌 워드 비트
+#endif
+
+int mm_init(void);
 static void* extend_heap(size_t words);
 static void* coalesce(void* bp);
 void* mm_malloc(size_t size);
 static void* first_fit(size_t a_size);
 static void place(void* bp, size_t a_size);
 void mm_free(void* bp);
+static void free_block(void* bp);
+static void consolidate(void);
 void* mm_realloc(void* bp, size_t size);
 
 void putFreeBlock(void* bp); // 프리블록 리스트에 블록 추가
 void rmFreeBlock(void* bp); // 프리블록 리스트에서 블록 삭제
+#ifdef ADDRESS_ORDERED
+static int region_reserve(size_t incr);
+static void region_mark(size_t r);
+static long region_before(size_t r);
+static void* region_pred(void* bp);
+#endif
 
 ///////
 // mm_init 
 int mm_init(void)
 {   
+    for (int i = 0; i < QUICK_LISTS; i++) { // quick list 비우기
+        quick_list[i] = NULL;
+    }
+    quick_count = 0;
+
     // 메모리 확장 실패
     if ((heap_list = mem_sbrk(6 * WSIZE)) == (void*)-1) {
         return -1;
@@ -68,12 +124,22 @@ int mm_init(void)
 
     PUTTER(heap_list, 0);                             // 시작 부분
     PUTTER(heap_list + (1 * WSIZE), PACK(2 * DSIZE, 1)); // 맨 앞 헤더 할당된 것
-    PUTTER(heap_list + (2 * WSIZE), NULL);            // 이전 포인터 null
-    PUTTER(heap_list + (3 * WSIZE), NULL);            // 이후 포인터 null
+    SET_PRED_FREEPT(heap_list + (2 * WSIZE), NULL);   // 이전 포인터 null
+    SET_SUCC_FREEPT(heap_list + (2 * WSIZE), NULL);   // 이후 포인터 null
     PUTTER(heap_list + (4 * WSIZE), PACK(2 * DSIZE, 1));  // 풋터 
-    PUTTER(heap_list + (5 * WSIZE), PACK(0, 1));      // 뒷부분 헤더
+    PUTTER(heap_list + (5 * WSIZE), PACK(0, 1) | PREV_ALLOC);      // 뒷부분 헤더
 
     free_list = heap_list + (2 * WSIZE); // 프리 블록 리스트의 시작을 맨 앞 다음 첫 프리블록으로
+#ifdef NEXT_FIT
+    rover = free_list;
+#endif
+#ifdef ADDRESS_ORDERED
+    if (region_first != NULL) { // 이전 힙의 인덱스 비우기
+        memset(region_first, 0, region_cap * sizeof(void*));
+        memset(region_bits, 0, (region_cap >> 6) * sizeof(unsigned long long));
+        memset(region_sum, 0, ((region_cap >> 12) + 1) * sizeof(unsigned long long));
+    }
+#endif
 
     if (extend_heap(CHUNKSIZE / WSIZE) == NULL) // 확장 ~
         return -1;
@@ -84,7 +150,7 @@ int mm_init(void)
 // Coalesce
 static void* coalesce(void* bp) 
 {
-    size_t prev_alloc = IS_ALLOCATED(FTPT(PREV_BLKP(bp))); // 이전 할당 여부
+    size_t prev_alloc = IS_PREV_ALLOCATED(HDPT(bp)); // 이전 할당 여부
     size_t next_alloc = IS_ALLOCATED(HDPT(NEXT_BLKP(bp))); // 이후 할당 여부
     size_t size = GET_SIZE(HDPT(bp));
 
@@ -92,7 +158,7 @@ static void* coalesce(void* bp)
         rmFreeBlock(NEXT_BLKP(bp)); // 프리 블록 리스트에서 다음 블록 제거
 
         size += GET_SIZE(HDPT(NEXT_BLKP(bp))); // 다음 블록의 크기 추가
-        PUTTER(HDPT(bp), PACK(size, 0));   // 헤더와 풋터 업데이트
+        PUTTER(HDPT(bp), PACK(size, 0) | PREV_ALLOC);   // 헤더와 풋터 업데이트
         PUTTER(FTPT(bp), PACK(size, 0));
     }
     else if (!prev_alloc && next_alloc) {   // 이전 블록이 프리
@@ -101,7 +167,7 @@ static void* coalesce(void* bp)
         size += GET_SIZE(HDPT(PREV_BLKP(bp))); // 이전 블록의 크기 추가
 
         PUTTER(FTPT(bp), PACK(size, 0)); // 현재 블록 풋터 업데이트
-        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0)); // 이전 블록 헤더 업데이트
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC); // 이전 블록 헤더 업데이트
 
         bp = PREV_BLKP(bp); // 블록 포인터를 이전 블록으로 이동
     }
@@ -111,7 +177,7 @@ static void* coalesce(void* bp)
 
         size += GET_SIZE(HDPT(PREV_BLKP(bp))) + GET_SIZE(FTPT(NEXT_BLKP(bp))); // 이전 블록과 다음 블록의 크기 추가
 
-        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0)); // 이전 블록 헤더 업데이트
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC); // 이전 블록 헤더 업데이트
         PUTTER(FTPT(NEXT_BLKP(bp)), PACK(size, 0)); // 다음 블록 풋터 업데이트
 
         bp = PREV_BLKP(bp); // 블록 포인터를 이전 블록으로 이동
@@ -129,11 +195,16 @@ static void* extend_heap(size_t words) { // 힙 확장
     size = (words % 2) ? (words + 1) * WSIZE : words * WSIZE; // 짝수 크기로 할당
 
     // 힙 확장에 실패하면
+#ifdef ADDRESS_ORDERED
+    if (region_reserve(size) == -1) { // 늘어난 힙까지 인덱스 확보
+        return NULL;
+    }
+#endif
     if ((long)(bp = mem_sbrk(size)) == -1) {
         return NULL;
     }
 
-    PUTTER(HDPT(bp), PACK(size, 0));   // 프리 블록 헤더
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp)));   // 프리 블록 헤더
     PUTTER(FTPT(bp), PACK(size, 0));   // 프리 블록 풋터
     PUTTER(HDPT(NEXT_BLKP(bp)), PACK(0, 1));   // 새 에필로그 헤더
 
@@ -151,16 +222,29 @@ void* mm_malloc(size_t size) {
     }
 
     // 할당할 프리블록 찾기
-    if (size <= DSIZE) { // 최소 블록 크기 이하로 요청 받은 경우 최소 크기 블록으로 할당
+    if (size <= DSIZE + WSIZE) { // 최소 블록 크기 이하로 요청 받은 경우 최소 크기 블록으로 할당
         a_size = 2 * DSIZE;
     }
     else { // 요청보다 더 크게 할당
-        // 헤더와 풋터를 위한 size + DSIZE
-        a_size = ((size + DSIZE - 1 + DSIZE) / DSIZE) * DSIZE;
+        // 할당 블록은 헤더만 있으므로 size + WSIZE
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
     }
 
-    // 적절한 프리 블록 탐색
-    if ((bp = worst_fit(a_size)) != NULL) {
+    // 같은 크기 블록이 quick list 에 있으면 병합/탐색 없이 바로 (LIFO)
+    if (a_size <= QUICK_MAX && quick_list[a_size / DSIZE] != NULL) {
+        bp = quick_list[a_size / DSIZE];
+        quick_list[a_size / DSIZE] = QUICK_NEXT(bp);
+        quick_count--;
+        return bp;
+    }
+
+    // 적절한 프리 블록 탐색, 못 찾으면 quick list 블록들을 병합하고 한 번 더
+    bp = first_fit(a_size);
+    if (bp == NULL && quick_count > 0) {
+        consolidate();
+        bp = first_fit(a_size);
+    }
+    if (bp != NULL) {
         place(bp, a_size);
         return bp;  // 프리 블록 적절한 것 발견했다면 return 후 종료
     }
@@ -173,18 +257,35 @@ void* mm_malloc(size_t size) {
     return bp;  // 성공하면 블록 시작 주소 리턴
 }
 
-// first_fit
+// first_fit : -DNEXT_FIT 이면 rover 부터 리스트 끝까지, 그 다음 처음부터 rover 앞까지 (next fit)
 static void* first_fit(size_t a_size) {
     void* bp;  // 블록 리스트를 순회할 포인터
+#ifdef NEXT_FIT
+    void* start = rover; // 탐색 시작 블록
+#else
+    void* start = free_list;
+#endif
 
     // End when the only allocated block in the free list (end of list) is found
-    for (bp = free_list; IS_ALLOCATED(HDPT(bp)) != 1; bp = SUCC_FREEPT(bp)) {
-        // 프리 블록 리스트 시작부터 리스트 끝까지 (할당된 블록이 리스트의 끝)
+    for (bp = start; IS_ALLOCATED(HDPT(bp)) != 1; bp = SUCC_FREEPT(bp)) {
+        // 시작 블록부터 리스트 끝까지 (할당된 블록이 리스트의 끝)
         if (GET_SIZE(HDPT(bp)) >= a_size) {
             // 현재 블록 사이즈가 요청 사이즈보다 크거나 같은 경우 !
+#ifdef NEXT_FIT
+            rover = bp; // place 에서 리스트에서 빠지며 rover 는 다음 블록으로
+#endif
+            return bp;
+        }
+    }
+
+#ifdef NEXT_FIT
+    for (bp = free_list; bp != start; bp = SUCC_FREEPT(bp)) { // 처음으로 돌아가 rover 앞까지
+        if (GET_SIZE(HDPT(bp)) >= a_size) {
+            rover = bp;
             return bp;
         }
     }
+#endif
 
     // fit한 블록 못 찾았다면
     return NULL;
@@ -197,70 +298,177 @@ static void place(void* bp, size_t a_size) { // 블록 포인터와 할당할 
     rmFreeBlock(bp); // 할당된 블록이므로 자유 블록 리스트에서 제거
 
     if ((c_size - a_size) >= (2 * DSIZE)) { // 블록을 분할할 충분한 공간이 있는 경우
-        PUTTER(HDPT(bp), PACK(a_size, 1)); // 헤더에 할당 정보와 크기 기록
-        PUTTER(FTPT(bp), PACK(a_size, 1)); // 풋터에 할당 정보와 크기 기록
+        PUTTER(HDPT(bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(bp))); // 헤더에 할당 정보와 크기 기록
 
         bp = NEXT_BLKP(bp); // 다음 블록으로 포인터 이동
 
-        PUTTER(HDPT(bp), PACK(c_size - a_size, 0)); // 남은 공간을 자유 블록으로 만듦
+        PUTTER(HDPT(bp), PACK(c_size - a_size, 0) | PREV_ALLOC); // 남은 공간을 자유 블록으로 만듦
         PUTTER(FTPT(bp), PACK(c_size - a_size, 0)); // 풋터에도 기록
 
         putFreeBlock(bp); // 분할된 자유 블록을 자유 블록 리스트에 추가
     }
     else { // 블록을 분할할 충분한 공간이 없는 경우
-        PUTTER(HDPT(bp), PACK(c_size, 1)); // 헤더에 할당 정보와 크기 기록
-        PUTTER(FTPT(bp), PACK(c_size, 1)); // 풋터에 할당 정보와 크기 기록
+        PUTTER(HDPT(bp), PACK(c_size, 1) | IS_PREV_ALLOCATED(HDPT(bp))); // 헤더에 할당 정보와 크기 기록
+        SET_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 할당 블록은 풋터 없이 다음 블록 헤더에 표시
     }
 }
 
 // putFreeBlock
 void putFreeBlock(void* bp) { // 프리 블록을 프리 블록 리스트에 추가
-    SUCC_FREEPT(bp) = free_list; // 프리 블록 리스트의 시작 블록을 다음 블록으로 설정
-    PRED_FREEPT(bp) = NULL; // 이전 블록 포인터 NULL로
+#ifdef ADDRESS_ORDERED
+    void* pred = region_pred(bp); // 주소순으로 바로 앞 프리 블록 (없으면 맨 앞에)
+    void* succ = (pred != NULL) ? SUCC_FREEPT(pred) : free_list; // 바로 뒤 (끝이면 센티넬)
+    size_t r = REGION_OF(bp);
+
+    SET_SUCC_FREEPT(bp, succ);
+    SET_PRED_FREEPT(bp, pred);
+    SET_PRED_FREEPT(succ, bp);
+    if (pred != NULL) {
+        SET_SUCC_FREEPT(pred, bp);
+    }
+    else {
+        free_list = bp;
+    }
+    if (region_first[r] == NULL || (char*)bp < (char*)region_first[r]) { // 칸의 첫 블록 갱신
+        region_first[r] = bp;
+        region_mark(r);
+    }
+    return;
+#endif
+    SET_SUCC_FREEPT(bp, free_list); // 프리 블록 리스트의 시작 블록을 다음 블록으로 설정
+    SET_PRED_FREEPT(bp, NULL); // 이전 블록 포인터 NULL로
     if (free_list != NULL) { // 프리 블록 리스트가 비어있지 않으면
-        PRED_FREEPT(free_list) = bp; // 원래의 프리 블록 리스트의 시작 블록의 이전 블록 포인터를 현재 블록으로 설정
+        SET_PRED_FREEPT(free_list, bp); // 원래의 프리 블록 리스트의 시작 블록의 이전 블록 포인터를 현재 블록으로 설정
     }
     free_list = bp; // 프리 블록 리스트의 시작 포인터를 현재 블록으로 설정
 }
 
 // rmFreeBlock
 void rmFreeBlock(void* bp) { // 프리 블록 리스트에서 주어진 블록 제거
+#ifdef ADDRESS_ORDERED
+    size_t r = REGION_OF(bp);
+
+    if (region_first[r] == bp) { // 칸의 첫 블록이면 주소순 다음 블록이 같은 칸일 때만 물려줌
+        void* next = SUCC_FREEPT(bp);
+        region_first[r] = (IS_ALLOCATED(HDPT(next)) != 1 && REGION_OF(next) == r) ? next : NULL;
+        region_mark(r);
+    }
+#endif
+#ifdef NEXT_FIT
+    if (bp == rover) { // 병합이나 할당으로 rover 블록이 빠지면 다음 블록부터
+        rover = SUCC_FREEPT(bp);
+    }
+#endif
     if (bp == free_list) { // 주어진 블록이 프리 블록 리스트의 첫 번째 블록인 경우
         free_list = SUCC_FREEPT(bp); // 프리 블록 리스트의 시작 포인터를 다음 블록으로 설정
         if (free_list != NULL) { // 프리 블록 리스트가 비어있지 않으면
-            PRED_FREEPT(free_list) = NULL; // 다음 블록의 이전 블록 포인터를 NULL로 설정
+            SET_PRED_FREEPT(free_list, NULL); // 다음 블록의 이전 블록 포인터를 NULL로 설정
         }
     }
     else { // 주어진 블록이 리스트의 중간에 있는 경우
-        SUCC_FREEPT(PRED_FREEPT(bp)) = SUCC_FREEPT(bp); // 이전 블록의 다음 블록 포인터를 현재 블록의 다음 블록으로 설정
+        SET_SUCC_FREEPT(PRED_FREEPT(bp), SUCC_FREEPT(bp)); // 이전 블록의 다음 블록 포인터를 현재 블록의 다음 블록으로 설정
         if (SUCC_FREEPT(bp) != NULL) { // 다음 블록이 NULL이 아니면
-            PRED_FREEPT(SUCC_FREEPT(bp)) = PRED_FREEPT(bp); // 다음 블록의 이전 블록 포인터를 현재 블록의 이전 블록으로 설정
+            SET_PRED_FREEPT(SUCC_FREEPT(bp), PRED_FREEPT(bp)); // 다음 블록의 이전 블록 포인터를 현재 블록의 이전 블록으로 설정
         }
     }
 }
 
-// mm_free
+// mm_free : 작은 블록은 할당 상태 그대로 quick list 에 넣고 병합은 미룸
 void mm_free(void* bp)
+{
+    size_t size = GET_SIZE(HDPT(bp)); // 블록 크기
+
+    if (size <= QUICK_MAX) {
+        QUICK_NEXT(bp) = quick_list[size / DSIZE];
+        quick_list[size / DSIZE] = bp;
+        if (++quick_count > QUICK_LIMIT) { // 너무 많이 모였으면 한꺼번에 병합
+            consolidate();
+        }
+        return;
+    }
+    free_block(bp);
+}
+
+// consolidate : quick list 블록을 전부 실제로 해제하고 병합
+static void consolidate(void) {
+    void* bp;
+
+    for (int i = 0; i < QUICK_LISTS; i++) {
+        while ((bp = quick_list[i]) != NULL) {
+            quick_list[i] = QUICK_NEXT(bp);
+            free_block(bp);
+        }
+    }
+    quick_count = 0;
+}
+
+// free_block : 프리 블록으로 바꾸고 이웃과 병합
+static void free_block(void* bp)
 {
     size_t size = GET_SIZE(HDPT(bp)); // 블록 해제를 위해 매개변수 받기
 
-    PUTTER(HDPT(bp), PACK(size, 0)); // 프리블록으로 상태 변경
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp))); // 프리블록으로 상태 변경
     PUTTER(FTPT(bp), PACK(size, 0));
+    CLR_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 다음 블록에 이전 블록 프리 표시
     coalesce(bp); // 프리 블록 병합
 }
 
-// mm_realloc
+// mm_realloc : 뒤 블록이 프리거나 힙 끝이면 제자리에서 늘리고, 줄일 때는 뒷부분을 돌려줌
 void* mm_realloc(void* bp, size_t size)
 {
     void* old_bp = bp; // 기존 블록 포인터
     void* new_bp;  // 새로 할당되는 블록 할당 포인터
     size_t copySize; // 복사 데이터 크기
+    size_t a_size; // 새로 필요한 블록 크기
+    size_t c_size = GET_SIZE(HDPT(old_bp)); // 기존 블록 크기
+    size_t n_size = c_size; // 제자리에서 쓸 수 있는 크기
+    void* next_bp = NEXT_BLKP(old_bp); // 다음 블록
+
+    if (size <= DSIZE + WSIZE) { // mm_malloc 과 같은 방식으로 블록 크기 계산
+        a_size = 2 * DSIZE;
+    }
+    else {
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
+    }
+
+    // 다음 블록이 프리면 합쳐서 쓸 수 있음
+    if (!IS_ALLOCATED(HDPT(next_bp))) {
+        n_size += GET_SIZE(HDPT(next_bp));
+    }
+    // 그래도 모자라는데 힙의 마지막 블록이면 모자란 만큼만 힙 확장
+    if (n_size < a_size && GET_SIZE(HDPT((char*)old_bp + n_size)) == 0
+#ifdef ADDRESS_ORDERED
+        && region_reserve(a_size - n_size) == 0
+#endif
+        && (long)mem_sbrk(a_size - n_size) != -1) {
+        n_size = a_size;
+        PUTTER(HDPT((char*)old_bp + n_size), PACK(0, 1)); // 새 에필로그 헤더
+    }
+
+    if (n_size >= a_size) { // 제자리에서 늘리거나 줄이기
+        if (n_size != c_size && !IS_ALLOCATED(HDPT(next_bp))) { // 합칠 다음 블록은 프리 리스트에서 제거
+            rmFreeBlock(next_bp);
+        }
+        if ((n_size - a_size) >= (2 * DSIZE)) { // 남는 부분이 최소 블록 이상이면 떼어서 프리 블록으로
+            PUTTER(HDPT(old_bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(old_bp)));
+            next_bp = NEXT_BLKP(old_bp);
+            PUTTER(HDPT(next_bp), PACK(n_size - a_size, 0) | PREV_ALLOC);
+            PUTTER(FTPT(next_bp), PACK(n_size - a_size, 0));
+            CLR_PREV_ALLOC(HDPT(NEXT_BLKP(next_bp)));
+            coalesce(next_bp); // 그 뒤 블록이 프리면 합쳐짐
+        }
+        else {
+            PUTTER(HDPT(old_bp), PACK(n_size, 1) | IS_PREV_ALLOCATED(HDPT(old_bp)));
+            SET_PREV_ALLOC(HDPT(NEXT_BLKP(old_bp)));
+        }
+        return old_bp;
+    }
 
     new_bp = mm_malloc(size); // 새 블록 할당
 
     if (new_bp == NULL) return NULL;
 
-    copySize = GET_SIZE(HDPT(old_bp)); // 기존 블록 크기
+    copySize = c_size - WSIZE; // 기존 블록 페이로드 크기
 
     if (size < copySize) // 재할당할 크기가 기존보다 작으면
         copySize = size; // 원래 size만큼조정
@@ -272,3 +480,103 @@ void* mm_realloc(void* bp, size_t size)
 
     return new_bp; // 실패시 블록 할당 역할
 }
+
+#ifdef ADDRESS_ORDERED
+/////// 주소순 리스트 인덱스
+
+// region_reserve : 힙이 incr 만큼 늘어도 모든 칸이 인덱스 배열에 들어가도록 미리 늘림 (비트맵도 같이)
+// 배열 하나만 늘고 실패하면 그 배열은 커진 채로 두고 칸 수는 그대로 (다음에 다시 늘림)
+static int region_reserve(size_t incr) {
+    size_t need = ((mem_heapsize() + incr) >> REGION_SHIFT) + 1; // 필요한 칸 수
+    size_t cap = (region_cap != 0) ? region_cap : REGION_MIN; // 새 칸 수
+    void* p;
+    void* b;
+    void* q;
+
+    if (need <= region_cap) {
+        return 0;
+    }
+    while (cap < need) {
+        cap *= 2;
+    }
+    if (region_first == NULL) { // 익명 매핑이라 0 (빈 칸) 으로 시작
+        p = mmap(NULL, cap * sizeof(void*), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        b = mmap(NULL, (cap >> 6) * sizeof(unsigned long long), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        q = mmap(NULL, ((cap >> 12) + 1) * sizeof(unsigned long long), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    else { // 늘어난 부분도 0
+        p = mremap(region_first, region_cap * sizeof(void*), cap * sizeof(void*), MREMAP_MAYMOVE);
+        b = mremap(region_bits, (region_cap >> 6) * sizeof(unsigned long long), (cap >> 6) * sizeof(unsigned long long), MREMAP_MAYMOVE);
+        q = mremap(region_sum, ((region_cap >> 12) + 1) * sizeof(unsigned long long), ((cap >> 12) + 1) * sizeof(unsigned long long), MREMAP_MAYMOVE);
+    }
+    if (p != MAP_FAILED) {
+        region_first = p;
+    }
+    if (b != MAP_FAILED) {
+        region_bits = b;
+    }
+    if (q != MAP_FAILED) {
+        region_sum = q;
+    }
+    if (p == MAP_FAILED || b == MAP_FAILED || q == MAP_FAILED) {
+        return -1;
+    }
+    region_cap = cap;
+    return 0;
+}
+
+// region_mark : r 칸에 첫 블록이 생겼거나 없어졌으면 비트맵에 반영
+static void region_mark(size_t r) {
+    if (region_first[r] != NULL) {
+        region_bits[r >> 6] |= BIT(r);
+        region_sum[r >> 12] |= BIT(r >> 6);
+    }
+    else {
+        region_bits[r >> 6] &= ~BIT(r);
+        if (region_bits[r >> 6] == 0) { // 워드가 비었으면 요약에서도
+            region_sum[r >> 12] &= ~BIT(r >> 6);
+        }
+    }
+}
+
+// region_before : r 칸보다 앞쪽으로 첫 블록이 있는 가장 가까운 칸 (없으면 -1)
+// 같은 워드 -> 같은 요약 워드 -> 앞 요약 워드들 (요약 워드 하나가 칸 4096 개) 순서로 clz
+static long region_before(size_t r) {
+    size_t w = r >> 6; // region_bits 워드
+    size_t v = r >> 12; // region_sum 워드
+    unsigned long long m = region_bits[w] & (BIT(r) - 1); // 같은 워드의 앞 칸들
+
+    if (m == 0) {
+        m = region_sum[v] & (BIT(w) - 1); // 같은 요약 워드의 앞 워드들
+        while (m == 0) {
+            if (v == 0) {
+                return -1;
+            }
+            m = region_sum[--v];
+        }
+        w = (v << 6) + 63 - __builtin_clzll(m);
+        m = region_bits[w];
+    }
+    return (long)((w << 6) + 63 - __builtin_clzll(m));
+}
+
+// region_pred : bp 보다 주소가 작은 프리 블록 중 가장 뒤 블록 (없으면 NULL)
+static void* region_pred(void* bp) {
+    size_t r = REGION_OF(bp);
+    void* p = region_first[r]; // 걷기 시작할 블록
+
+    if (p == NULL || (char*)p > (char*)bp) { // 같은 칸에 앞 블록이 없으면 앞쪽으로 가장 가까운 칸
+        long q = region_before(r);
+
+        if (q < 0) {
+            return NULL;
+        }
+        p = region_first[q];
+    }
+    // 그 칸 안에서 bp 바로 앞까지 (사이 칸들은 비어 있으므로 칸 하나만 걸음)
+    while (IS_ALLOCATED(HDPT(SUCC_FREEPT(p))) != 1 && (char*)SUCC_FREEPT(p) < (char*)bp) {
+        p = SUCC_FREEPT(p);
+    }
+    return p;
+}
+#endif
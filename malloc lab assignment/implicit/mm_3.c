@@ -1,4 +1,7 @@
 // Implicit Linked List - Best fit
+// + 칸별 프리 블록 크기 클래스 비트맵을 세그먼트 트리로 (부모는 자식 OR) 모아, 루트에서 요청 이상 가장 작은 클래스를 고르고
+//   그 클래스 블록이 있는 가장 앞쪽 칸 하나만 걸음, O(log n)
+//   512 미만은 클래스마다 크기 하나라 정확한 best fit (같은 크기면 앞 주소), 그 위는 클래스 폭 (2의 거듭제곱의 1/8) 안의 good fit
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,6 +9,8 @@
 #include <unistd.h>
 #include <string.h>
 
+#include <sys/mman.h>
+
 #include "mm.h"
 #include "memlib.h"
 
@@ -17,6 +22,28 @@
 
 #define MAX(x, y)   ((x) > (y) ? (x) : (y))   
 
+/////// quick list : 최근 해제된 작은 블록을 병합 없이 크기별로 모아 두었다가 같은 크기 요청에 바로 재사용
+#define QUICK_MAX   64                      // quick list 로 처리하는 최대 블록 크기
+#define QUICK_LISTS (QUICK_MAX / DSIZE + 1) // 블록 크기 / DSIZE 가 리스트 번호 (정확히 같은 크기만)
+#define QUICK_LIMIT 128                     // 모인 블록 수가 이보다 많아지면 전부 병합 (consolidate)
+
+#define QUICK_NEXT(bp) (*(void**)(bp)) // quick list 안 다음 블록 (할당 상태 블록의 페이로드 첫 칸)
+
+/////// 칸 인덱스 : 힙을 REGION 칸으로 나눠 칸마다 (그 칸에서 시작하는) 프리 블록들의 크기 클래스 비트맵을 세그먼트 트리로 관리
+// 탐색은 클래스를 루트에서 고르고 그 클래스가 있는 칸만 트리로 골라 그 칸의 블록만 걸음 (힙 전체를 걷지 않음)
+#define REGION_SHIFT    12      // 칸 크기 4KB
+#define REGION_MIN      64      // 처음 잎 수 (2의 거듭제곱, 모자라면 두 배로 다시 만듦)
+#define REGION_OF(bp)   ((size_t)((char*)(bp) - (char*)mem_heap_lo()) >> REGION_SHIFT)   // 블록이 속한 칸
+
+/////// 크기 클래스 : EXACT_MAX 미만은 DSIZE 간격 크기 하나씩, 그 위는 2의 거듭제곱을 2^CLASS_SUB 등분 (블록 크기는 2^32 미만)
+#define EXACT_SHIFT     9                       // EXACT_MAX = 512
+#define EXACT_MAX       (1 << EXACT_SHIFT)
+#define CLASS_SUB       3                       // 2의 거듭제곱 하나를 8 클래스로
+#define CLASS_COUNT     256                     // EXACT_MAX / DSIZE + (32 - EXACT_SHIFT) * 8 = 248 이상, 64 의 배수
+#define CLASS_WORDS     (CLASS_COUNT / 64)      // 노드 하나의 비트맵 워드 수
+#define REGION_MAP(i)   (region_map + (i) * CLASS_WORDS)    // i 노드의 클래스 비트맵
+#define HAS_CLASS(i, c) ((REGION_MAP(i)[(c) / 64] >> ((c) % 64)) & 1)   // i 노드 구간에 c 클래스 프리 블록이 있음
+
 // 정보 (블록 사이즈와 할당 여부에 대한 정보를 헤더와 풋터에 넣어야 함)
 #define PACK(size, alloc)   ((size) | (alloc))
 
@@ -25,6 +52,11 @@
 
 #define GET_SIZE(p)    (GETTER(p) & ~0x7)   // 블록 크기
 #define IS_ALLOCATED(p)   (GETTER(p) & 0x1)  // 블록 할당 여부
+#define IS_PREV_ALLOCATED(p)   (GETTER(p) & 0x2)   // 이전 블록 할당 여부 (헤더에만 기록)
+#define PREV_ALLOC  0x2   // 헤더의 이전 블록 할당 비트
+
+#define SET_PREV_ALLOC(p)   PUTTER(p, GETTER(p) | PREV_ALLOC)   // 이전 블록 할당 표시
+#define CLR_PREV_ALLOC(p)   PUTTER(p, GETTER(p) & ~PREV_ALLOC)  // 이전 블록 프리 표시
 
 #define HDPT(bp)    ((char *)(bp) - WSIZE)  // 헤더 포인터
 #define FTPT(bp)    ((char *)(bp) + GET_SIZE(HDPT(bp)) - DSIZE)  // 풋터 포인터
@@ -34,31 +66,61 @@
 
 
 static void* heap_list = NULL;
+static void* quick_list[QUICK_LISTS]; // 크기별 quick list (LIFO)
+static int quick_count; // quick list 에 모인 블록 수
+static void** region_first; // 칸마다 그 칸에서 시작하는 첫 블록 (에필로그 포함, 없으면 NULL)
+static unsigned long long* region_map; // 세그먼트 트리 (1 이 루트, region_cap + r 이 r 칸 잎) : 구간 프리 블록들의 클래스 비트맵
+static size_t region_cap; // 잎 수
 
-static int mm_init(void);
+int mm_init(void);
 static void* extend_heap(size_t words);
 static void* coalesce(void* bp);
 void* mm_malloc(size_t size);
 static void* best_fit(size_t a_size);
 static void place(void* bp, size_t a_size);
 void mm_free(void* bp);
+static void free_block(void* bp);
+static void consolidate(void);
 void* mm_realloc(void* bp, size_t size);
 
+static int region_reserve(size_t incr);
+static void region_add(void* x);
+static void region_del(void* x, void* next);
+static void region_update(size_t r);
+static long region_find(size_t from, int c);
+static int size_class(size_t size);
+static size_t class_base(int c);
+static int class_first(const unsigned long long* map, int from);
+
 ///////
 // mm_init 
 int mm_init(void)
 {
+    for (int i = 0; i < QUICK_LISTS; i++) { // quick list 비우기
+        quick_list[i] = NULL;
+    }
+    quick_count = 0;
+    if (region_first != NULL) { // 이전 힙의 칸 인덱스 비우기
+        memset(region_first, 0, region_cap * sizeof(void*));
+        memset(region_map, 0, 2 * region_cap * CLASS_WORDS * sizeof(unsigned long long));
+    }
+
     // 메모리 확장 실패
     if ((heap_list = mem_sbrk(4 * WSIZE)) == (void*)-1) {
         return -1;
     }
+    if (region_reserve(0) == -1) {
+        return -1;
+    }
 
     PUTTER(heap_list, 0);                            // 시작 부분
     PUTTER(heap_list + (1 * WSIZE), PACK(DSIZE, 1));    // 맨 앞 헤더 할당된 것
     PUTTER(heap_list + (2 * WSIZE), PACK(DSIZE, 1));    // 풋터
-    PUTTER(heap_list + (3 * WSIZE), PACK(0, 1));        // 뒷부분 에필로그 헤더
+    PUTTER(heap_list + (3 * WSIZE), PACK(0, 1) | PREV_ALLOC);        // 뒷부분 에필로그 헤더
 
     heap_list += (2 * WSIZE); // 힙 리스트의 포인터를 맨 앞 블록의 끝으로 , 블록 관리
+    region_add(heap_list); // 프롤로그와 에필로그 경계
+    region_add((char*)heap_list + (2 * WSIZE));
 
     if (extend_heap(CHUNKSIZE / WSIZE) == NULL) { // 청크 사이즈만큼 힙 확장 -> 실패하면 -1
         return -1;
@@ -73,14 +135,15 @@ static void* extend_heap(size_t words) { // 힙 확장
 
     size = (words % 2) ? (words + 1) * WSIZE : words * WSIZE; // 짝수 크기로 할당
 
-    // 힙 확장에 실패하면
-    if ((long)(bp = mem_sbrk(size)) == -1) {
+    // 힙 확장에 실패하면 (칸 인덱스도 함께 확보)
+    if (region_reserve(size) == -1 || (long)(bp = mem_sbrk(size)) == -1) {
         return NULL;
     }
 
-    PUTTER(HDPT(bp), PACK(size, 0));   // 프리 블록 헤더
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp)));   // 프리 블록 헤더
     PUTTER(FTPT(bp), PACK(size, 0));   // 프리 블록 풋터
     PUTTER(HDPT(NEXT_BLKP(bp)), PACK(0, 1));   // 새 에필로그 헤더
+    region_add(NEXT_BLKP(bp)); // 새 에필로그 경계 (옛 에필로그 자리는 새 블록)
 
     return coalesce(bp); // 이전 블록이 프리블록이면 합쳐 !
 }
@@ -88,19 +151,22 @@ static void* extend_heap(size_t words) { // 힙 확장
 // coalesce
 static void* coalesce(void* bp) { // 프리 블록끼리 합치기
     // 할당 상태 저장
-    size_t prev_alloc = IS_ALLOCATED(FTPT(PREV_BLKP(bp))); // 할당 여부 확인
+    size_t prev_alloc = IS_PREV_ALLOCATED(HDPT(bp)); // 할당 여부 확인
     size_t next_alloc = IS_ALLOCATED(HDPT(NEXT_BLKP(bp)));
     size_t size = GET_SIZE(HDPT(bp)); // 크기 값 저장
+    void* next_bp = NEXT_BLKP(bp); // 합쳐지면 없어지는 경계
+    void* cur_bp = bp;
 
     // 모두 할당된 경우
     if (prev_alloc && next_alloc) {
+        region_update(REGION_OF(bp));
         return bp;
     }
 
     // 다음이 프리블록이면
     else if (prev_alloc && !next_alloc) {
         size += GET_SIZE(HDPT(NEXT_BLKP(bp))); // 현재 블록의 크기에 다음 블록 크기 더해
-        PUTTER(HDPT(bp), PACK(size, 0)); // 헤더와 풋터 업데이트
+        PUTTER(HDPT(bp), PACK(size, 0) | PREV_ALLOC); // 헤더와 풋터 업데이트
         PUTTER(FTPT(bp), PACK(size, 0));
     }
 
@@ -108,18 +174,29 @@ static void* coalesce(void* bp) { // 프리 블록끼리 합치기
     else if (!prev_alloc && next_alloc) {
         size += GET_SIZE(HDPT(PREV_BLKP(bp))); // 현재 블록의 크기에 이전 블록 크기 더해
         PUTTER(FTPT(bp), PACK(size, 0));   // 헤더와 풋터 업데이트
-        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0));
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC);
         bp = PREV_BLKP(bp);
     }
 
     // 앞뒤 모두 프리블록이면
     else {
         size += GET_SIZE(HDPT(PREV_BLKP(bp))) + GET_SIZE(FTPT(NEXT_BLKP(bp))); // 현재 블록의 크기에 다음과 이전 블록 크기 더해
-        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0)); // 헤더와 풋터 업데이트
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC); // 헤더와 풋터 업데이트
         PUTTER(FTPT(NEXT_BLKP(bp)), PACK(size, 0));
         bp = PREV_BLKP(bp);
     }
 
+    // 없어진 경계 정리하고 바뀐 칸들의 가장 큰 프리 블록 다시 계산
+    if (!next_alloc) {
+        region_del(next_bp, NEXT_BLKP(bp));
+        region_update(REGION_OF(next_bp));
+    }
+    if (!prev_alloc) {
+        region_del(cur_bp, NEXT_BLKP(bp));
+        region_update(REGION_OF(cur_bp));
+    }
+    region_update(REGION_OF(bp));
+
     return bp; // 합쳐진 블록의 시작 주소 리턴
 }
 
@@ -134,16 +211,29 @@ void* mm_malloc(size_t size) {
     }
 
     // 할당할 프리블록 찾기
-    if (size <= DSIZE) { // 최소 블록 크기 이하로 요청 받은 경우 최소 크기 블록으로 할당
+    if (size <= DSIZE + WSIZE) { // 최소 블록 크기 이하로 요청 받은 경우 최소 크기 블록으로 할당
         a_size = 2 * DSIZE;
     }
     else { // 요청보다 더 크게 할당
-        // 헤더와 풋터를 위한 size + DSIZE
-        a_size = ((size + DSIZE - 1 + DSIZE) / DSIZE) * DSIZE;
+        // 할당 블록은 헤더만 있으므로 size + WSIZE
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
     }
 
-    // 적절한 프리 블록 탐색
-    if ((bp = best_fit(a_size)) != NULL) {
+    // 같은 크기 블록이 quick list 에 있으면 병합/탐색 없이 바로 (LIFO)
+    if (a_size <= QUICK_MAX && quick_list[a_size / DSIZE] != NULL) {
+        bp = quick_list[a_size / DSIZE];
+        quick_list[a_size / DSIZE] = QUICK_NEXT(bp);
+        quick_count--;
+        return bp;
+    }
+
+    // 적절한 프리 블록 탐색, 못 찾으면 quick list 블록들을 병합하고 한 번 더
+    bp = best_fit(a_size);
+    if (bp == NULL && quick_count > 0) {
+        consolidate();
+        bp = best_fit(a_size);
+    }
+    if (bp != NULL) {
         place(bp, a_size);
         return bp;  // 프리 블록 적절한 것 발견했다면 return 후 종료
     }
@@ -156,82 +246,164 @@ void* mm_malloc(size_t size) {
     return bp;  // 성공하면 블록 시작 주소 리턴
 }
 
-// best_fit
+// best_fit : 요청이 모두 들어가는 가장 작은 클래스를 루트 비트맵에서 고르고, 그 클래스가 있는 가장 앞쪽 칸에서 그 클래스 첫 블록
+// 위 클래스에 없으면 요청 크기가 든 클래스 (더 작은 블록도 섞임) 를 칸마다 보며 맞는 블록 (힙 확장 전 마지막)
 static void* best_fit(size_t a_size) {
-    void* bp;  // 현재 탐색 중인 블록 
-    void* best = NULL;  // 가장 fit한 블록을 가리키는 포인터 . 아직은 NULL
-    size_t b_size;  // 현재 가장 fit한 블록의 크기 저장 (비교 위함)
-
-    for (bp = (char*)heap_list; GET_SIZE(HDPT(bp)) > 0; bp = NEXT_BLKP(bp)) { 
-        // 힙의 시작 주소부터 힙의 끝(크기가 0인 블록)까지 반복 
-        if (!IS_ALLOCATED(HDPT(bp)) && (a_size <= GET_SIZE(HDPT(bp)))) {
-            // 현재 블록이 할당되지 않고 요청 크기 이상인 경우 -'> fit
-            b_size = GET_SIZE(HDPT(bp)); // 크기 저장
-            best = bp;  // 포인터로 저장
-            break;
-        } // 다음 반복으로 !!
-    }
-
-    if (best == NULL) return NULL; // fit한 블록 찾지 못했다면 아직 best 포인터는 비어있음
+    void* bp;  // 현재 탐색 중인 블록
+    int c = size_class(a_size); // 찾을 클래스
+    long r; // 그 클래스가 있는 칸
 
-    // 최적의 블록 탐색
-    for (; GET_SIZE(HDPT(bp)) > 0; bp = NEXT_BLKP(bp)) {
-        // 설정된 best 외에 나머지 부분 탐색해서 또 찾기
-        if (!IS_ALLOCATED(HDPT(bp)) && (a_size <= GET_SIZE(HDPT(bp)))) {
-            // 현재 블록이 할당되지 않고 요청 크기 이상인 경우 -'> fit
-            if (b_size >= GET_SIZE(HDPT(bp))) {  // 현재 블록 크기가 임시 best보다 작거나 같으면
-                b_size = GET_SIZE(HDPT(bp)); // 업데이트 !!!
-                best = bp;
+    if (class_base(c) < a_size) { // 클래스에 요청보다 작은 블록도 있으면 다음 클래스부터 (모두 맞음)
+        c++;
+    }
+    if ((c = class_first(REGION_MAP(1), c)) >= 0) {
+        r = region_find(0, c);
+        for (bp = region_first[r]; GET_SIZE(HDPT(bp)) > 0; bp = NEXT_BLKP(bp)) { // 칸 안에 반드시 있음
+            if (!IS_ALLOCATED(HDPT(bp)) && size_class(GET_SIZE(HDPT(bp))) == c) {
+                return bp;
             }
         }
     }
 
-    return best;
+    c = size_class(a_size);
+    for (r = region_find(0, c); r >= 0; r = region_find(r + 1, c)) {
+        for (bp = region_first[r]; REGION_OF(bp) == (size_t)r && GET_SIZE(HDPT(bp)) > 0; bp = NEXT_BLKP(bp)) {
+            if (!IS_ALLOCATED(HDPT(bp)) && a_size <= GET_SIZE(HDPT(bp))) {
+                return bp;
+            }
+        }
+    }
+    return NULL;
 }
 
 // place
 static void place(void* bp, size_t a_size) {  // 블록 포인터와 할당할 크기
     size_t c_size = GET_SIZE(HDPT(bp)); // 현재 블록의 크기
+    size_t r = REGION_OF(bp); // 할당할 블록 칸
 
     if ((c_size - a_size) >= (2 * (DSIZE))) { // 요청된 크기를 최소 크기로 쪼갤 수 있다면
 
-        PUTTER(HDPT(bp), PACK(a_size, 1)); // 현재 헤더와 풋터에 할당 정보와 크기 업데이트
-        PUTTER(FTPT(bp), PACK(a_size, 1));
+        PUTTER(HDPT(bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(bp))); // 현재 헤더와 풋터에 할당 정보와 크기 업데이트
 
         bp = NEXT_BLKP(bp); // 다음 블록으로 이동
 
         // 남은 공간의 헤더와 풋터는 할당되지 않은 상태 0
-        PUTTER(HDPT(bp), PACK(c_size - a_size, 0));
+        PUTTER(HDPT(bp), PACK(c_size - a_size, 0) | PREV_ALLOC);
         PUTTER(FTPT(bp), PACK(c_size - a_size, 0));
+        region_add(bp); // 남은 프리 블록 경계
+        region_update(REGION_OF(bp));
     }
     else { // 블록 크기 불충분해서 분할 불가 (남은 공간이 최소보다 작아서)
-        PUTTER(HDPT(bp), PACK(c_size, 1));  // 할당 상태 1
-        PUTTER(FTPT(bp), PACK(c_size, 1));
+        PUTTER(HDPT(bp), PACK(c_size, 1) | IS_PREV_ALLOCATED(HDPT(bp)));  // 할당 상태 1
+        SET_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 할당 블록은 풋터 없이 다음 블록 헤더에 표시
     }
+    region_update(r);
 }
 
-// mm_free
+// mm_free : 작은 블록은 할당 상태 그대로 quick list 에 넣고 병합은 미룸
 void mm_free(void* bp)
+{
+    size_t size = GET_SIZE(HDPT(bp)); // 블록 크기
+
+    if (size <= QUICK_MAX) {
+        QUICK_NEXT(bp) = quick_list[size / DSIZE];
+        quick_list[size / DSIZE] = bp;
+        if (++quick_count > QUICK_LIMIT) { // 너무 많이 모였으면 한꺼번에 병합
+            consolidate();
+        }
+        return;
+    }
+    free_block(bp);
+}
+
+// consolidate : quick list 블록을 전부 실제로 해제하고 병합
+static void consolidate(void) {
+    void* bp;
+
+    for (int i = 0; i < QUICK_LISTS; i++) {
+        while ((bp = quick_list[i]) != NULL) {
+            quick_list[i] = QUICK_NEXT(bp);
+            free_block(bp);
+        }
+    }
+    quick_count = 0;
+}
+
+// free_block : 프리 블록으로 바꾸고 이웃과 병합
+static void free_block(void* bp)
 {
     size_t size = GET_SIZE(HDPT(bp)); // 블록 해제를 위해 매개변수 받기
 
-    PUTTER(HDPT(bp), PACK(size, 0)); // 프리블록으로 상태 변경
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp))); // 프리블록으로 상태 변경
     PUTTER(FTPT(bp), PACK(size, 0));
+    CLR_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 다음 블록에 이전 블록 프리 표시
     coalesce(bp); // 프리 블록 병합
 }
 
-// mm_realloc
+// mm_realloc : 뒤 블록이 프리거나 힙 끝이면 제자리에서 늘리고, 줄일 때는 뒷부분을 돌려줌
 void* mm_realloc(void* bp, size_t size)
 {
     void* old_bp = bp; // 기존 블록 포인터
     void* new_bp;  // 새로 할당되는 블록 할당 포인터
     size_t copySize; // 복사 데이터 크기
+    size_t a_size; // 새로 필요한 블록 크기
+    size_t c_size = GET_SIZE(HDPT(old_bp)); // 기존 블록 크기
+    size_t n_size = c_size; // 제자리에서 쓸 수 있는 크기
+    void* next_bp = NEXT_BLKP(old_bp); // 다음 블록
+    size_t next_r = REGION_OF(next_bp); // 다음 블록 칸
+    void* old_end = NULL; // 힙을 늘렸으면 옛 에필로그 자리
+
+    if (size <= DSIZE + WSIZE) { // mm_malloc 과 같은 방식으로 블록 크기 계산
+        a_size = 2 * DSIZE;
+    }
+    else {
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
+    }
+
+    // 다음 블록이 프리면 합쳐서 쓸 수 있음
+    if (!IS_ALLOCATED(HDPT(next_bp))) {
+        n_size += GET_SIZE(HDPT(next_bp));
+    }
+    // 그래도 모자라는데 힙의 마지막 블록이면 모자란 만큼만 힙 확장
+    if (n_size < a_size && GET_SIZE(HDPT((char*)old_bp + n_size)) == 0
+        && region_reserve(a_size - n_size) == 0 && (long)mem_sbrk(a_size - n_size) != -1) {
+        old_end = (char*)old_bp + n_size;
+        n_size = a_size;
+        PUTTER(HDPT((char*)old_bp + n_size), PACK(0, 1)); // 새 에필로그 헤더
+    }
+
+    if (n_size >= a_size) { // 제자리에서 늘리거나 줄이기
+        if (n_size != c_size) { // 합쳐지는 경계 (다음 프리 블록, 옛 에필로그) 정리
+            region_add((char*)old_bp + n_size);
+            region_del(next_bp, (char*)old_bp + n_size);
+            if (old_end != NULL) {
+                region_del(old_end, (char*)old_bp + n_size);
+            }
+        }
+        if ((n_size - a_size) >= (2 * DSIZE)) { // 남는 부분이 최소 블록 이상이면 떼어서 프리 블록으로
+            PUTTER(HDPT(old_bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(old_bp)));
+            next_bp = NEXT_BLKP(old_bp);
+            PUTTER(HDPT(next_bp), PACK(n_size - a_size, 0) | PREV_ALLOC);
+            PUTTER(FTPT(next_bp), PACK(n_size - a_size, 0));
+            region_add(next_bp); // 떼어 낸 프리 블록 경계
+            CLR_PREV_ALLOC(HDPT(NEXT_BLKP(next_bp)));
+            coalesce(next_bp); // 그 뒤 블록이 프리면 합쳐짐
+        }
+        else {
+            PUTTER(HDPT(old_bp), PACK(n_size, 1) | IS_PREV_ALLOCATED(HDPT(old_bp)));
+            SET_PREV_ALLOC(HDPT(NEXT_BLKP(old_bp)));
+        }
+        if (n_size != c_size) { // 합쳐진 다음 프리 블록이 있던 칸
+            region_update(next_r);
+        }
+        return old_bp;
+    }
 
     new_bp = mm_malloc(size); // 새 블록 할당
 
     if (new_bp == NULL) return NULL;
 
-    copySize = GET_SIZE(HDPT(old_bp)); // 기존 블록 크기
+    copySize = c_size - WSIZE; // 기존 블록 페이로드 크기
 
     if (size < copySize) // 재할당할 크기가 기존보다 작으면
         copySize = size; // 원래 size만큼조정
@@ -243,3 +415,150 @@ void* mm_realloc(void* bp, size_t size)
 
     return new_bp; // 실패시 블록 할당 역할
 }
+
+/////// 칸 인덱스
+
+// region_reserve : 힙이 incr 만큼 늘어도 모든 칸이 잎에 들어가도록 미리 늘림 (새로 만들어 옮기고 부모는 다시 계산)
+static int region_reserve(size_t incr) {
+    size_t need = ((mem_heapsize() + incr) >> REGION_SHIFT) + 1; // 필요한 칸 수
+    size_t cap = (region_cap != 0) ? region_cap : REGION_MIN; // 새 잎 수
+    void** first;
+    unsigned long long* map;
+
+    if (need <= region_cap) {
+        return 0;
+    }
+    while (cap < need) {
+        cap *= 2;
+    }
+    // 익명 매핑이라 0 (빈 칸) 으로 시작
+    first = mmap(NULL, cap * sizeof(void*), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    map = mmap(NULL, 2 * cap * CLASS_WORDS * sizeof(unsigned long long), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (first == MAP_FAILED || map == MAP_FAILED) {
+        if (first != MAP_FAILED) {
+            munmap(first, cap * sizeof(void*));
+        }
+        if (map != MAP_FAILED) {
+            munmap(map, 2 * cap * CLASS_WORDS * sizeof(unsigned long long));
+        }
+        return -1;
+    }
+    if (region_cap != 0) { // 옛 칸과 잎 옮기기
+        memcpy(first, region_first, region_cap * sizeof(void*));
+        memcpy(map + cap * CLASS_WORDS, REGION_MAP(region_cap), region_cap * CLASS_WORDS * sizeof(unsigned long long));
+        munmap(region_first, region_cap * sizeof(void*));
+        munmap(region_map, 2 * region_cap * CLASS_WORDS * sizeof(unsigned long long));
+    }
+    for (size_t i = cap - 1; i > 0; i--) { // 부모 다시 계산
+        for (int w = 0; w < CLASS_WORDS; w++) {
+            map[i * CLASS_WORDS + w] = map[2 * i * CLASS_WORDS + w] | map[(2 * i + 1) * CLASS_WORDS + w];
+        }
+    }
+    region_first = first;
+    region_map = map;
+    region_cap = cap;
+    return 0;
+}
+
+// region_add : x 에 블록 경계가 생김 (칸의 첫 블록 갱신)
+static void region_add(void* x) {
+    size_t r = REGION_OF(x);
+
+    if (region_first[r] == NULL || (char*)x < (char*)region_first[r]) {
+        region_first[r] = x;
+    }
+}
+
+// region_del : x 의 블록 경계가 없어짐, next 는 x 뒤로 남아 있는 첫 경계
+static void region_del(void* x, void* next) {
+    size_t r = REGION_OF(x);
+
+    if (region_first[r] == x) { // 칸의 첫 블록이었으면 다음 경계가 같은 칸일 때만 물려줌
+        region_first[r] = (REGION_OF(next) == r) ? next : NULL;
+    }
+}
+
+// region_update : r 칸의 블록을 걸어서 프리 블록 클래스 비트맵을 다시 만들고 루트 쪽으로 갱신
+static void region_update(size_t r) {
+    void* bp;
+    unsigned long long map[CLASS_WORDS] = { 0 }; // 칸의 클래스 비트맵
+    size_t i = region_cap + r; // 잎
+    int c;
+
+    for (bp = region_first[r]; bp != NULL && REGION_OF(bp) == r && GET_SIZE(HDPT(bp)) > 0; bp = NEXT_BLKP(bp)) {
+        if (!IS_ALLOCATED(HDPT(bp))) {
+            c = size_class(GET_SIZE(HDPT(bp)));
+            map[c / 64] |= 1ull << (c % 64);
+        }
+    }
+    memcpy(REGION_MAP(i), map, sizeof(map));
+    for (i /= 2; i > 0; i /= 2) { // 부모 값이 그대로면 그 위도 그대로
+        for (int w = 0; w < CLASS_WORDS; w++) {
+            map[w] = REGION_MAP(2 * i)[w] | REGION_MAP(2 * i + 1)[w];
+        }
+        if (memcmp(REGION_MAP(i), map, sizeof(map)) == 0) {
+            break;
+        }
+        memcpy(REGION_MAP(i), map, sizeof(map));
+    }
+}
+
+// region_find : from 칸부터 c 클래스 프리 블록이 있는 가장 앞쪽 칸 (없으면 -1), O(log n)
+static long region_find(size_t from, int c) {
+    size_t i = region_cap + from; // 잎부터
+
+    if (from >= region_cap) {
+        return -1;
+    }
+    while (!HAS_CLASS(i, c)) {
+        while (i & 1) { // 오른쪽 자식이면 올라가기
+            i >>= 1;
+        }
+        if (i == 0) { // 루트를 지났으면 없음
+            return -1;
+        }
+        i++; // 오른쪽 형제 구간으로
+    }
+    while (i < region_cap) { // c 클래스가 있는 가장 왼쪽 잎으로 내려가기
+        i = HAS_CLASS(2 * i, c) ? 2 * i : 2 * i + 1;
+    }
+    return (long)(i - region_cap);
+}
+
+/////// 크기 클래스
+
+// size_class : 블록 크기의 클래스 번호
+static int size_class(size_t size) {
+    int p; // floor(log2(size))
+
+    if (size < EXACT_MAX) {
+        return (int)(size / DSIZE);
+    }
+    p = 63 - __builtin_clzll((unsigned long long)size);
+    return EXACT_MAX / DSIZE + ((p - EXACT_SHIFT) << CLASS_SUB) + (int)((size >> (p - CLASS_SUB)) & ((1 << CLASS_SUB) - 1));
+}
+
+// class_base : c 클래스의 가장 작은 블록 크기
+static size_t class_base(int c) {
+    int p; // 2의 거듭제곱
+
+    if (c < EXACT_MAX / DSIZE) {
+        return (size_t)c * DSIZE;
+    }
+    c -= EXACT_MAX / DSIZE;
+    p = EXACT_SHIFT + (c >> CLASS_SUB);
+    return ((size_t)1 << p) + ((size_t)(c & ((1 << CLASS_SUB) - 1)) << (p - CLASS_SUB));
+}
+
+// class_first : 비트맵에서 from 이상 가장 작은 클래스 (없으면 -1)
+static int class_first(const unsigned long long* map, int from) {
+    unsigned long long m;
+
+    for (int w = from / 64; w < CLASS_WORDS; w++) {
+        m = (w == from / 64) ? map[w] & (~0ull << (from % 64)) : map[w];
+        if (m != 0) {
+            return w * 64 + __builtin_ctzll(m);
+        }
+    }
+    return -1;
+}
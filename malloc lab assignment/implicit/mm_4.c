@@ -1,4 +1,7 @@
 // Implicit Linked List - Worst fit
+// + 프리 블록은 크기 기준 최대 힙으로도 관리해서 가장 큰 블록을 힙 전체 탐색 없이 찾음
+
+#define _GNU_SOURCE // mremap
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,6 +9,8 @@
 #include <unistd.h>
 #include <string.h>
 
+#include <sys/mman.h>
+
 #include "mm.h"
 #include "memlib.h"
 
@@ -16,6 +21,18 @@
 
 #define MAX(x, y)   ((x) > (y) ? (x) : (y))   
 
+/////// quick list : 최근 해제된 작은 블록을 병합 없이 크기별로 모아 두었다가 같은 크기 요청에 바로 재사용
+#define QUICK_MAX   64                      // quick list 로 처리하는 최대 블록 크기
+#define QUICK_LISTS (QUICK_MAX / DSIZE + 1) // 블록 크기 / DSIZE 가 리스트 번호 (정확히 같은 크기만)
+#define QUICK_LIMIT 128                     // 모인 블록 수가 이보다 많아지면 전부 병합 (consolidate)
+
+#define QUICK_NEXT(bp) (*(void**)(bp)) // quick list 안 다음 블록 (할당 상태 블록의 페이로드 첫 칸)
+
+/////// 최대 힙 : 프리 블록을 크기 기준 최대 힙 배열로 관리 (가장 큰 블록 O(1), 추가/삭제 O(log n))
+#define MAX_HEAP_MIN    1024    // 배열 처음 칸 수 (모자라면 두 배씩 mremap)
+
+#define HEAP_INDEX(bp)  (*(unsigned int*)(bp)) // 프리 블록의 배열 인덱스 (페이로드 첫 워드)
+
 // 정보 (블록 사이즈와 할당 여부에 대한 정보를 헤더와 풋터에 넣어야 함)
 #define PACK(size, alloc)   ((size) | (alloc))
 
@@ -24,6 +41,11 @@
 
 #define GET_SIZE(p)    (GETTER(p) & ~0x7)   // 블록 크기
 #define IS_ALLOCATED(p)   (GETTER(p) & 0x1)  // 블록 할당 여부
+#define IS_PREV_ALLOCATED(p)   (GETTER(p) & 0x2)   // 이전 블록 할당 여부 (헤더에만 기록)
+#define PREV_ALLOC  0x2   // 헤더의 이전 블록 할당 비트
+
+#define SET_PREV_ALLOC(p)   PUTTER(p, GETTER(p) | PREV_ALLOC)   // 이전 블록 할당 표시
+#define CLR_PREV_ALLOC(p)   PUTTER(p, GETTER(p) & ~PREV_ALLOC)  // 이전 블록 프리 표시
 
 #define HDPT(bp)    ((char *)(bp) - WSIZE)  // 헤더 포인터
 #define FTPT(bp)    ((char *)(bp) + GET_SIZE(HDPT(bp)) - DSIZE)  // 풋터 포인터
@@ -33,20 +55,39 @@
 
 
 static void* heap_list = NULL;
+static void* quick_list[QUICK_LISTS]; // 크기별 quick list (LIFO)
+static int quick_count; // quick list 에 모인 블록 수
+static void** max_heap; // 프리 블록 최대 힙 배열 (mmap, mm_init 이 다시 불려도 재사용)
+static size_t max_count; // 힙에 든 블록 수
+static size_t max_cap; // 배열 칸 수
 
-static int mm_init(void);
+int mm_init(void);
 static void* extend_heap(size_t words);
 static void* coalesce(void* bp);
 void* mm_malloc(size_t size);
 static void* worst_fit(size_t a_size);
 static void place(void* bp, size_t a_size);
 void mm_free(void* bp);
+static void free_block(void* bp);
+static void consolidate(void);
 void* mm_realloc(void* bp, size_t size);
 
+static int max_reserve(size_t incr);
+static void max_push(void* bp);
+static void max_remove(void* bp);
+static void max_up(size_t i);
+static void max_down(size_t i);
+
 ///////
 // mm_init 
 int mm_init(void)
 {
+    for (int i = 0; i < QUICK_LISTS; i++) { // quick list 비우기
+        quick_list[i] = NULL;
+    }
+    quick_count = 0;
+    max_count = 0;
+
     // 메모리 확장 실패
     if ((heap_list = mem_sbrk(4 * WSIZE)) == (void*)-1) {
         return -1;
@@ -55,7 +96,7 @@ int mm_init(void)
     PUTTER(heap_list, 0);                            // 시작 부분
     PUTTER(heap_list + (1 * WSIZE), PACK(DSIZE, 1));    // 맨 앞 헤더 할당된 것
     PUTTER(heap_list + (2 * WSIZE), PACK(DSIZE, 1));    // 풋터
-    PUTTER(heap_list + (3 * WSIZE), PACK(0, 1));        // 뒷부분 에필로그 헤더
+    PUTTER(heap_list + (3 * WSIZE), PACK(0, 1) | PREV_ALLOC);        // 뒷부분 에필로그 헤더
 
     heap_list += (2 * WSIZE); // 힙 리스트의 포인터를 맨 앞 블록의 끝으로 , 블록 관리
 
@@ -72,12 +113,12 @@ static void* extend_heap(size_t words) { // 힙 확장
 
     size = (words % 2) ? (words + 1) * WSIZE : words * WSIZE; // 짝수 크기로 할당
 
-    // 힙 확장에 실패하면
-    if ((long)(bp = mem_sbrk(size)) == -1) {
+    // 힙 확장에 실패하면 (최대 힙 배열도 함께 확보)
+    if (max_reserve(size) == -1 || (long)(bp = mem_sbrk(size)) == -1) {
         return NULL;
     }
 
-    PUTTER(HDPT(bp), PACK(size, 0));   // 프리 블록 헤더
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp)));   // 프리 블록 헤더
     PUTTER(FTPT(bp), PACK(size, 0));   // 프리 블록 풋터
     PUTTER(HDPT(NEXT_BLKP(bp)), PACK(0, 1));   // 새 에필로그 헤더
 
@@ -87,38 +128,44 @@ static void* extend_heap(size_t words) { // 힙 확장
 // coalesce
 static void* coalesce(void* bp) { // 프리 블록끼리 합치기
     // 할당 상태 저장
-    size_t prev_alloc = IS_ALLOCATED(FTPT(PREV_BLKP(bp))); // 할당 여부 확인
+    size_t prev_alloc = IS_PREV_ALLOCATED(HDPT(bp)); // 할당 여부 확인
     size_t next_alloc = IS_ALLOCATED(HDPT(NEXT_BLKP(bp)));
     size_t size = GET_SIZE(HDPT(bp)); // 크기 값 저장
 
     // 모두 할당된 경우
     if (prev_alloc && next_alloc) {
+        max_push(bp); // 최대 힙에 추가
         return bp;
     }
 
     // 다음이 프리블록이면
     else if (prev_alloc && !next_alloc) {
+        max_remove(NEXT_BLKP(bp)); // 다음 블록 최대 힙에서 제거
         size += GET_SIZE(HDPT(NEXT_BLKP(bp))); // 현재 블록의 크기에 다음 블록 크기 더해
-        PUTTER(HDPT(bp), PACK(size, 0)); // 헤더와 풋터 업데이트
+        PUTTER(HDPT(bp), PACK(size, 0) | PREV_ALLOC); // 헤더와 풋터 업데이트
         PUTTER(FTPT(bp), PACK(size, 0));
     }
 
     // 이전이 프리블록이면 
     else if (!prev_alloc && next_alloc) {
+        max_remove(PREV_BLKP(bp)); // 이전 블록 최대 힙에서 제거
         size += GET_SIZE(HDPT(PREV_BLKP(bp))); // 현재 블록의 크기에 이전 블록 크기 더해
         PUTTER(FTPT(bp), PACK(size, 0));   // 헤더와 풋터 업데이트
-        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0));
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC);
         bp = PREV_BLKP(bp);
     }
 
     // 앞뒤 모두 프리블록이면
     else {
+        max_remove(PREV_BLKP(bp)); // 이전, 다음 블록 최대 힙에서 제거
+        max_remove(NEXT_BLKP(bp));
         size += GET_SIZE(HDPT(PREV_BLKP(bp))) + GET_SIZE(FTPT(NEXT_BLKP(bp))); // 현재 블록의 크기에 다음과 이전 블록 크기 더해
-        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0)); // 헤더와 풋터 업데이트
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC); // 헤더와 풋터 업데이트
         PUTTER(FTPT(NEXT_BLKP(bp)), PACK(size, 0));
         bp = PREV_BLKP(bp);
     }
 
+    max_push(bp); // 합쳐진 블록 최대 힙에 추가
     return bp; // 합쳐진 블록의 시작 주소 리턴
 }
 
@@ -133,16 +180,29 @@ void* mm_malloc(size_t size) {
     }
 
     // 할당할 프리블록 찾기
-    if (size <= DSIZE) { // 최소 블록 크기 이하로 요청 받은 경우 최소 크기 블록으로 할당
+    if (size <= DSIZE + WSIZE) { // 최소 블록 크기 이하로 요청 받은 경우 최소 크기 블록으로 할당
         a_size = 2 * DSIZE;
     }
     else { // 요청보다 더 크게 할당
-        // 헤더와 풋터를 위한 size + DSIZE
-        a_size = ((size + DSIZE - 1 + DSIZE) / DSIZE) * DSIZE;
+        // 할당 블록은 헤더만 있으므로 size + WSIZE
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
     }
 
-    // 적절한 프리 블록 탐색
-    if ((bp = worst_fit(a_size)) != NULL) {
+    // 같은 크기 블록이 quick list 에 있으면 병합/탐색 없이 바로 (LIFO)
+    if (a_size <= QUICK_MAX && quick_list[a_size / DSIZE] != NULL) {
+        bp = quick_list[a_size / DSIZE];
+        quick_list[a_size / DSIZE] = QUICK_NEXT(bp);
+        quick_count--;
+        return bp;
+    }
+
+    // 적절한 프리 블록 탐색, 못 찾으면 quick list 블록들을 병합하고 한 번 더
+    bp = worst_fit(a_size);
+    if (bp == NULL && quick_count > 0) {
+        consolidate();
+        bp = worst_fit(a_size);
+    }
+    if (bp != NULL) {
         place(bp, a_size);
         return bp;  // 프리 블록 적절한 것 발견했다면 return 후 종료
     }
@@ -155,82 +215,130 @@ void* mm_malloc(size_t size) {
     return bp;  // 성공하면 블록 시작 주소 리턴
 }
 
-// worst_fit
+// worst_fit : 최대 힙의 맨 위가 가장 큰 프리 블록
 static void* worst_fit(size_t a_size) {
-    void* bp;  // 현재 탐색 중인 블록
-    void* worst = NULL;  // 가장 fit한 블록을 가리키는 포인터 . 아직은 NULL
-    size_t w_size;  // 현재 가장 fit한 블록의 크기 저장 (비교 위함)
-
-    for (bp = (char*)heap_list; GET_SIZE(HDPT(bp)) > 0; bp = NEXT_BLKP(bp)) { 
-        // 힙의 시작 주소부터 힙의 끝(크기가 0인 블록)까지 반복 
-        if (!IS_ALLOCATED(HDPT(bp)) && (a_size <= GET_SIZE(HDPT(bp)))) {
-            // 현재 블록이 할당되지 않고 요청 크기 이상인 경우 -> fit
-            w_size = GET_SIZE(HDPT(bp)); // 크기 저장
-            worst = bp;
-            break;
-        }  // 다음 반복으로 !!!
-    }
-
-    if (worst == NULL) return NULL; // fit한 블록 찾지 못했다면 아직 worst 포인터는 비어있음
-
-    // 최적의 블록 탐색
-    for (; GET_SIZE(HDPT(bp)) > 0; bp = NEXT_BLKP(bp)) {
-        // 설정된 worst 외에 나머지 부분 탐색해서 또 찾기
-        if (!IS_ALLOCATED(HDPT(bp)) && (a_size <= GET_SIZE(HDPT(bp)))) {
-            // 현재 블록이 할당되지 않고 요청 크기 이상인 경우 -> fit
-            if (w_size <= GET_SIZE(HDPT(bp))) {  // 현재 블록 크기가 임시 best보다 크거나 같으면
-                w_size = GET_SIZE(HDPT(bp)); // 업데이트 !!!
-                worst = bp;
-            }
-        }
+    if (max_count == 0 || GET_SIZE(HDPT(max_heap[0])) < a_size) { // 가장 큰 블록도 모자라면 NULL
+        return NULL;
     }
-
-    return worst;
+    return max_heap[0];
 }
 
 // place
 static void place(void* bp, size_t a_size) {  // 블록 포인터와 할당할 크기
     size_t c_size = GET_SIZE(HDPT(bp)); // 현재 블록의 크기
 
+    max_remove(bp); // 할당할 블록이므로 최대 힙에서 제거
+
     if ((c_size - a_size) >= (2 * (DSIZE))) { // 요청된 크기를 최소 크기로 쪼갤 수 있다면
 
-        PUTTER(HDPT(bp), PACK(a_size, 1)); // 현재 헤더와 풋터에 할당 정보와 크기 업데이트
-        PUTTER(FTPT(bp), PACK(a_size, 1));
+        PUTTER(HDPT(bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(bp))); // 현재 헤더와 풋터에 할당 정보와 크기 업데이트
 
         bp = NEXT_BLKP(bp); // 다음 블록으로 이동
 
         // 남은 공간의 헤더와 풋터는 할당되지 않은 상태 0
-        PUTTER(HDPT(bp), PACK(c_size - a_size, 0));
+        PUTTER(HDPT(bp), PACK(c_size - a_size, 0) | PREV_ALLOC);
         PUTTER(FTPT(bp), PACK(c_size - a_size, 0));
+        max_push(bp); // 남은 프리 블록 최대 힙에 추가
     }
     else { // 블록 크기 불충분해서 분할 불가 (남은 공간이 최소보다 작아서)
-        PUTTER(HDPT(bp), PACK(c_size, 1));  // 할당 상태 1
-        PUTTER(FTPT(bp), PACK(c_size, 1));
+        PUTTER(HDPT(bp), PACK(c_size, 1) | IS_PREV_ALLOCATED(HDPT(bp)));  // 할당 상태 1
+        SET_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 할당 블록은 풋터 없이 다음 블록 헤더에 표시
     }
 }
 
-// mm_free
+// mm_free : 작은 블록은 할당 상태 그대로 quick list 에 넣고 병합은 미룸
 void mm_free(void* bp)
+{
+    size_t size = GET_SIZE(HDPT(bp)); // 블록 크기
+
+    if (size <= QUICK_MAX) {
+        QUICK_NEXT(bp) = quick_list[size / DSIZE];
+        quick_list[size / DSIZE] = bp;
+        if (++quick_count > QUICK_LIMIT) { // 너무 많이 모였으면 한꺼번에 병합
+            consolidate();
+        }
+        return;
+    }
+    free_block(bp);
+}
+
+// consolidate : quick list 블록을 전부 실제로 해제하고 병합
+static void consolidate(void) {
+    void* bp;
+
+    for (int i = 0; i < QUICK_LISTS; i++) {
+        while ((bp = quick_list[i]) != NULL) {
+            quick_list[i] = QUICK_NEXT(bp);
+            free_block(bp);
+        }
+    }
+    quick_count = 0;
+}
+
+// free_block : 프리 블록으로 바꾸고 이웃과 병합
+static void free_block(void* bp)
 {
     size_t size = GET_SIZE(HDPT(bp)); // 블록 해제를 위해 매개변수 받기
 
-    PUTTER(HDPT(bp), PACK(size, 0)); // 프리블록으로 상태 변경
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp))); // 프리블록으로 상태 변경
     PUTTER(FTPT(bp), PACK(size, 0));
+    CLR_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 다음 블록에 이전 블록 프리 표시
     coalesce(bp); // 프리 블록 병합
 }
 
-// mm_realloc
+// mm_realloc : 뒤 블록이 프리거나 힙 끝이면 제자리에서 늘리고, 줄일 때는 뒷부분을 돌려줌
 void* mm_realloc(void* bp, size_t size)
 {
     void* old_bp = bp; // 기존 블록 포인터
     void* new_bp;  // 새로 할당되는 블록 할당 포인터
     size_t copySize; // 복사 데이터 크기
+    size_t a_size; // 새로 필요한 블록 크기
+    size_t c_size = GET_SIZE(HDPT(old_bp)); // 기존 블록 크기
+    size_t n_size = c_size; // 제자리에서 쓸 수 있는 크기
+    void* next_bp = NEXT_BLKP(old_bp); // 다음 블록
+
+    if (size <= DSIZE + WSIZE) { // mm_malloc 과 같은 방식으로 블록 크기 계산
+        a_size = 2 * DSIZE;
+    }
+    else {
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
+    }
+
+    // 다음 블록이 프리면 합쳐서 쓸 수 있음
+    if (!IS_ALLOCATED(HDPT(next_bp))) {
+        n_size += GET_SIZE(HDPT(next_bp));
+    }
+    // 그래도 모자라는데 힙의 마지막 블록이면 모자란 만큼만 힙 확장
+    if (n_size < a_size && GET_SIZE(HDPT((char*)old_bp + n_size)) == 0
+        && max_reserve(a_size - n_size) == 0 && (long)mem_sbrk(a_size - n_size) != -1) {
+        n_size = a_size;
+        PUTTER(HDPT((char*)old_bp + n_size), PACK(0, 1)); // 새 에필로그 헤더
+    }
+
+    if (n_size >= a_size) { // 제자리에서 늘리거나 줄이기
+        if (n_size != c_size && !IS_ALLOCATED(HDPT(next_bp))) { // 합칠 다음 블록은 최대 힙에서 제거
+            max_remove(next_bp);
+        }
+        if ((n_size - a_size) >= (2 * DSIZE)) { // 남는 부분이 최소 블록 이상이면 떼어서 프리 블록으로
+            PUTTER(HDPT(old_bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(old_bp)));
+            next_bp = NEXT_BLKP(old_bp);
+            PUTTER(HDPT(next_bp), PACK(n_size - a_size, 0) | PREV_ALLOC);
+            PUTTER(FTPT(next_bp), PACK(n_size - a_size, 0));
+            CLR_PREV_ALLOC(HDPT(NEXT_BLKP(next_bp)));
+            coalesce(next_bp); // 그 뒤 블록이 프리면 합쳐짐
+        }
+        else {
+            PUTTER(HDPT(old_bp), PACK(n_size, 1) | IS_PREV_ALLOCATED(HDPT(old_bp)));
+            SET_PREV_ALLOC(HDPT(NEXT_BLKP(old_bp)));
+        }
+        return old_bp;
+    }
 
     new_bp = mm_malloc(size); // 새 블록 할당
 
     if (new_bp == NULL) return NULL;
 
-    copySize = GET_SIZE(HDPT(old_bp)); // 기존 블록 크기
+    copySize = c_size - WSIZE; // 기존 블록 페이로드 크기
 
     if (size < copySize) // 재할당할 크기가 기존보다 작으면
         copySize = size; // 원래 size만큼조정
@@ -242,3 +350,87 @@ void* mm_realloc(void* bp, size_t size)
 
     return new_bp; // 실패시 블록 할당 역할
 }
+
+/////// 최대 힙
+
+// max_reserve : 힙이 incr 만큼 늘어도 모든 프리 블록이 배열에 들어가도록 미리 늘림
+// 프리 블록은 서로 붙어 있지 않으므로 (최소 블록 + 할당 블록) 마다 많아야 하나
+static int max_reserve(size_t incr) {
+    size_t need = (mem_heapsize() + incr) / (4 * DSIZE) + 2; // 필요한 칸 수
+    size_t cap = (max_cap != 0) ? max_cap : MAX_HEAP_MIN; // 새 칸 수
+    void* p;
+
+    if (need <= max_cap) {
+        return 0;
+    }
+    while (cap < need) {
+        cap *= 2;
+    }
+    if (max_heap == NULL) {
+        p = mmap(NULL, cap * sizeof(void*), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    else { // 페이지를 옮기므로 memcpy 없음
+        p = mremap(max_heap, max_cap * sizeof(void*), cap * sizeof(void*), MREMAP_MAYMOVE);
+    }
+    if (p == MAP_FAILED) {
+        return -1;
+    }
+    max_heap = p;
+    max_cap = cap;
+    return 0;
+}
+
+// max_push : 맨 끝에 넣고 위로
+static void max_push(void* bp) {
+    max_heap[max_count] = bp;
+    max_up(max_count++);
+}
+
+// max_remove : 마지막 블록을 bp 자리로 옮기고 위나 아래로
+static void max_remove(void* bp) {
+    size_t i = HEAP_INDEX(bp); // bp 자리
+    void* last = max_heap[--max_count]; // 마지막 블록
+
+    if (i == max_count) { // bp 가 마지막이었으면 끝
+        return;
+    }
+    max_heap[i] = last;
+    HEAP_INDEX(last) = i;
+    max_up(i);
+    max_down(HEAP_INDEX(last));
+}
+
+// max_up : 부모보다 크면 부모와 자리 바꾸기
+static void max_up(size_t i) {
+    void* bp = max_heap[i];
+    size_t size = GET_SIZE(HDPT(bp));
+
+    while (i > 0 && GET_SIZE(HDPT(max_heap[(i - 1) / 2])) < size) {
+        max_heap[i] = max_heap[(i - 1) / 2]; // 부모를 아래로
+        HEAP_INDEX(max_heap[i]) = i;
+        i = (i - 1) / 2;
+    }
+    max_heap[i] = bp;
+    HEAP_INDEX(bp) = i;
+}
+
+// max_down : 더 큰 자식보다 작으면 자식과 자리 바꾸기
+static void max_down(size_t i) {
+    void* bp = max_heap[i];
+    size_t size = GET_SIZE(HDPT(bp));
+    size_t c; // 더 큰 자식
+
+    while ((c = 2 * i + 1) < max_count) {
+        if (c + 1 < max_count && GET_SIZE(HDPT(max_heap[c + 1])) > GET_SIZE(HDPT(max_heap[c]))) {
+            c++;
+        }
+        if (GET_SIZE(HDPT(max_heap[c])) <= size) {
+            break;
+        }
+        max_heap[i] = max_heap[c]; // 자식을 위로
+        HEAP_INDEX(max_heap[i]) = i;
+        i = c;
+    }
+    max_heap[i] = bp;
+    HEAP_INDEX(bp) = i;
+}
@@ -0,0 +1,66 @@
+// new.cpp : C++ operator new / delete 를 preload 의 malloc / free 로 (bad_alloc 예외 때문에 C++ 로 따로)
+
+#include <new>
+#include <cstdlib>
+
+#define EXPORT  __attribute__((visibility("default")))
+
+// preload.c : 크기를 아는 해제 (변형에 mm_free_sized 가 없으면 free 와 같음)
+extern "C" void free_sized(void* ptr, std::size_t size);
+extern "C" void free_aligned_sized(void* ptr, std::size_t align, std::size_t size);
+
+// new_alloc : new_handler 가 있으면 부르고 다시, 없으면 bad_alloc
+static void* new_alloc(std::size_t size, std::size_t align)
+{
+    void* p;
+
+    if (align < __STDCPP_DEFAULT_NEW_ALIGNMENT__) { // 정렬 없는 new 도 16 정렬 (변형 malloc 은 8 정렬일 수 있음, 16 정렬 변형이면 preload 가 malloc 으로)
+        align = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+    }
+    for (;;) {
+        if (posix_memalign(&p, align, size) != 0) {
+            p = nullptr;
+        }
+        if (p != nullptr) {
+            return p;
+        }
+        std::new_handler h = std::get_new_handler();
+        if (h == nullptr) {
+            throw std::bad_alloc();
+        }
+        h();
+    }
+}
+
+// new_alloc_nothrow : 실패하면 nullptr
+static void* new_alloc_nothrow(std::size_t size, std::size_t align) noexcept
+{
+    try {
+        return new_alloc(size, align);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+EXPORT void* operator new(std::size_t size) { return new_alloc(size, 0); }
+EXPORT void* operator new[](std::size_t size) { return new_alloc(size, 0); }
+EXPORT void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return new_alloc_nothrow(size, 0); }
+EXPORT void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return new_alloc_nothrow(size, 0); }
+EXPORT void* operator new(std::size_t size, std::align_val_t al) { return new_alloc(size, (std::size_t)al); }
+EXPORT void* operator new[](std::size_t size, std::align_val_t al) { return new_alloc(size, (std::size_t)al); }
+EXPORT void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return new_alloc_nothrow(size, (std::size_t)al); }
+EXPORT void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return new_alloc_nothrow(size, (std::size_t)al); }
+
+EXPORT void operator delete(void* p) noexcept { std::free(p); }
+EXPORT void operator delete[](void* p) noexcept { std::free(p); }
+EXPORT void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+EXPORT void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+EXPORT void operator delete(void* p, std::size_t size) noexcept { free_sized(p, size); }
+EXPORT void operator delete[](void* p, std::size_t size) noexcept { free_sized(p, size); }
+EXPORT void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+EXPORT void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+EXPORT void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+EXPORT void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+EXPORT void operator delete(void* p, std::size_t size, std::align_val_t al) noexcept { free_aligned_sized(p, (std::size_t)al, size); }
+EXPORT void operator delete[](void* p, std::size_t size, std::align_val_t al) noexcept { free_aligned_sized(p, (std::size_t)al, size); }
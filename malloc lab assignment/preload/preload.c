@@ -0,0 +1,456 @@
+// preload : 변형 하나(mm_*.c)를 공유 라이브러리로 감싸 LD_PRELOAD 로 실제 프로그램의 malloc 을 바꿔치기
+//
+//   LD_PRELOAD=./build/libmm_9.so <프로그램>
+//
+// - malloc / free / calloc / realloc / posix_memalign / aligned_alloc / memalign / valloc / pvalloc / malloc_usable_size
+//   + C23 free_sized / free_aligned_sized (C++ 크기 있는 operator delete 도 이쪽, new.cpp)
+// - mm_init 전이나 mm_* 안에서 다시 불린 할당 (pthread, atfork 등록 등) 은 정적 버퍼에서 (부트스트랩)
+// - 변형들은 스레드 안전하지 않으므로 전역 락으로 감쌈 (스스로 락을 잡는 mm_8 은 -DMM_THREAD_SAFE 로 락 없이)
+// - 변형이 mm_memalign 을 주지 않으면 정렬 할당은 크게 받아 안쪽 정렬 주소를 돌려주고, 정렬 주소 -> 원래 주소 표로 free 때 되찾음
+// - x86-64 ABI 의 16 정렬: ALIGNMENT 옵션이 있는 mm_9 는 -DALIGNMENT=16 -DMM_ALIGN=16 으로 빌드해 malloc 부터 16 정렬
+//   나머지 변형의 malloc 은 8 정렬 (gcc 도 malloc 결과는 8 정렬로만 가정), C++ new 는 new.cpp 가 posix_memalign 으로 16 정렬
+// - mm_usable_size 가 없는 변형은 페이로드 바로 앞 4바이트 헤더 (크기 | 비트, 할당 블록 풋터 없음) 로 계산
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <sys/mman.h>
+
+#include "mm.h"
+#include "memlib.h"
+
+#define EXPORT          __attribute__((visibility("default")))
+#define INITIAL_EXEC    __attribute__((tls_model("initial-exec"))) // __tls_get_addr 가 malloc 을 부르지 않게
+
+#define BOOT_SIZE       (256 * 1024)    // 부트스트랩 버퍼 크기
+#define BOOT_ALIGN      16              // 부트스트랩 블록 정렬 (앞 16바이트에 크기)
+#ifndef MM_ALIGN
+#define MM_ALIGN        8               // 변형이 보장하는 정렬 (16 으로 빌드한 변형은 -DMM_ALIGN=16, Makefile)
+#endif
+
+#define TABLE_MIN       1024            // 정렬 주소 표 처음 칸 수 (2의 거듭제곱)
+#define TABLE_EMPTY     ((uintptr_t)0)  // 빈 칸
+#define TABLE_DEAD      ((uintptr_t)1)  // 지운 칸 (탐색은 계속)
+#define TABLE_HASH(key, cap)    ((size_t)(((key) >> 4) * 0x9E3779B97F4A7C15ull >> 32) & ((cap) - 1)) // 정렬 주소는 아래 비트가 0 이므로 섞기
+
+// 변형이 주면 쓰는 선택 함수들
+#pragma weak mm_usable_size
+#pragma weak mm_memalign
+#pragma weak mm_free_sized
+#pragma weak mm_atfork_prepare
+#pragma weak mm_atfork_parent
+#pragma weak mm_atfork_child
+
+typedef struct {
+    uintptr_t key;  // 돌려준 정렬 주소
+    void* base;     // mm_malloc 이 준 원래 주소
+} table_slot_t;
+
+static char boot_buf[BOOT_SIZE] __attribute__((aligned(BOOT_ALIGN))); // 부트스트랩 버퍼
+static size_t boot_used; // 부트스트랩 버퍼 사용량
+
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+static int ready; // mm_init 끝남
+static __thread int in_mm INITIAL_EXEC; // 이 스레드가 할당기 안에 있음 (재진입이면 부트스트랩으로)
+
+#ifndef MM_THREAD_SAFE
+static pthread_mutex_t mm_lock = PTHREAD_MUTEX_INITIALIZER; // 변형 전체를 감싸는 락
+#endif
+
+static pthread_mutex_t table_lock = PTHREAD_MUTEX_INITIALIZER;
+static table_slot_t* table; // 정렬 주소 -> 원래 주소 (열린 주소법)
+static size_t table_cap; // 칸 수
+static size_t table_used; // 쓰는 칸 + 지운 칸
+static size_t table_live; // 쓰는 칸 (0 이면 free 가 표를 보지 않음)
+
+static void preload_init(void);
+static void* boot_malloc(size_t size);
+static int is_boot(void* ptr);
+static size_t boot_size(void* ptr);
+static void lock(void);
+static void unlock(void);
+static void fork_prepare(void);
+static void fork_parent(void);
+static void fork_child(void);
+static size_t usable_size(void* bp);
+static void* aligned_malloc(size_t align, size_t size);
+static int table_put(void* ptr, void* base);
+static void* table_take(void* ptr, int remove);
+
+// preload_init : 힙 예약 + mm_init (처음 한 번)
+static void preload_init(void)
+{
+    in_mm = 1; // 여기서 불리는 할당은 부트스트랩으로
+    mem_init();
+    if (mm_init() < 0) {
+        fprintf(stderr, "preload: mm_init failed\n");
+        abort();
+    }
+    pthread_atfork(fork_prepare, fork_parent, fork_child); // fork 때 락이 잡힌 채로 복사되지 않게
+    ready = 1;
+    in_mm = 0;
+}
+
+// boot_malloc : 부트스트랩 버퍼에서 잘라 주기 (해제는 무시)
+static void* boot_malloc(size_t size)
+{
+    size_t need = BOOT_ALIGN + ((size + BOOT_ALIGN - 1) & ~(size_t)(BOOT_ALIGN - 1));
+    size_t off = __atomic_fetch_add(&boot_used, need, __ATOMIC_RELAXED);
+    char* p;
+
+    if (off + need > BOOT_SIZE) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    p = boot_buf + off + BOOT_ALIGN;
+    *(size_t*)(p - sizeof(size_t)) = size; // realloc 복사용 크기
+    return p;
+}
+
+static int is_boot(void* ptr)
+{
+    return (char*)ptr >= boot_buf && (char*)ptr < boot_buf + BOOT_SIZE;
+}
+
+static size_t boot_size(void* ptr)
+{
+    return *(size_t*)((char*)ptr - sizeof(size_t));
+}
+
+// lock : 변형 진입 (처음이면 초기화)
+static void lock(void)
+{
+    if (!ready) {
+        pthread_once(&init_once, preload_init);
+    }
+#ifndef MM_THREAD_SAFE
+    pthread_mutex_lock(&mm_lock);
+#endif
+    in_mm = 1;
+}
+
+static void unlock(void)
+{
+    in_mm = 0;
+#ifndef MM_THREAD_SAFE
+    pthread_mutex_unlock(&mm_lock);
+#endif
+}
+
+// fork_prepare : fork 직전 락을 모두 잡기 (스스로 락을 잡는 변형은 자기 락도 mm_atfork_* 로)
+static void fork_prepare(void)
+{
+#ifndef MM_THREAD_SAFE
+    pthread_mutex_lock(&mm_lock);
+#endif
+    if (mm_atfork_prepare != NULL) {
+        mm_atfork_prepare();
+    }
+    pthread_mutex_lock(&table_lock);
+}
+
+static void fork_parent(void)
+{
+    pthread_mutex_unlock(&table_lock);
+    if (mm_atfork_parent != NULL) {
+        mm_atfork_parent();
+    }
+#ifndef MM_THREAD_SAFE
+    pthread_mutex_unlock(&mm_lock);
+#endif
+}
+
+static void fork_child(void)
+{
+    pthread_mutex_init(&table_lock, NULL);
+    if (mm_atfork_child != NULL) {
+        mm_atfork_child();
+    }
+#ifndef MM_THREAD_SAFE
+    pthread_mutex_init(&mm_lock, NULL);
+#endif
+}
+
+// usable_size : 변형 블록의 페이로드 크기 (락 잡은 상태에서)
+static size_t usable_size(void* bp)
+{
+    if (mm_usable_size != NULL) {
+        return mm_usable_size(bp);
+    }
+    return (*(unsigned int*)((char*)bp - 4) & ~0x7) - 4; // 헤더 크기 - 헤더
+}
+
+EXPORT void* malloc(size_t size)
+{
+    void* bp;
+
+    if (in_mm) {
+        return boot_malloc(size);
+    }
+    lock();
+    bp = mm_malloc(size > 0 ? size : 1); // malloc(0) 도 free 할 수 있는 포인터
+    unlock();
+    if (bp == NULL) {
+        errno = ENOMEM;
+    }
+    return bp;
+}
+
+EXPORT void free(void* ptr)
+{
+    void* base;
+
+    if (ptr == NULL || is_boot(ptr)) {
+        return;
+    }
+    if (in_mm) { // 변형 안에서 자기 블록을 돌려주는 일은 없음
+        return;
+    }
+    if (__atomic_load_n(&table_live, __ATOMIC_RELAXED) > 0 && (base = table_take(ptr, 1)) != NULL) {
+        ptr = base; // 정렬 할당이면 원래 주소로
+    }
+    lock();
+    mm_free(ptr);
+    unlock();
+}
+
+// free_sized : 변형이 mm_free_sized 를 주면 (지금은 mm_8 만) 호출자가 아는 크기를 넘김, 다른 변형이나 정렬 표를 쓰는 중이면 free 로
+EXPORT void free_sized(void* ptr, size_t size)
+{
+    if (mm_free_sized == NULL || ptr == NULL || is_boot(ptr) || in_mm
+        || __atomic_load_n(&table_live, __ATOMIC_RELAXED) > 0) {
+        free(ptr);
+        return;
+    }
+    lock();
+    mm_free_sized(ptr, size > 0 ? size : 1); // malloc(0) 은 1 바이트로 할당했음
+    unlock();
+}
+
+// free_aligned_sized : 정렬 블록도 mm_memalign 이 준 블록이면 요청 크기로 해제 가능 (아니면 free_sized 가 free 로)
+EXPORT void free_aligned_sized(void* ptr, size_t align, size_t size)
+{
+    (void)align;
+    free_sized(ptr, size);
+}
+
+EXPORT void* calloc(size_t nmemb, size_t size)
+{
+    void* bp;
+
+    if (size != 0 && nmemb > (size_t)-1 / size) { // 곱셈 넘침
+        errno = ENOMEM;
+        return NULL;
+    }
+    if ((bp = malloc(nmemb * size)) != NULL && !is_boot(bp)) {
+        memset(bp, 0, nmemb * size); // 재사용 블록이 섞이므로 항상 0 으로 (부트스트랩 버퍼는 원래 0)
+    }
+    return bp;
+}
+
+EXPORT void* realloc(void* ptr, size_t size)
+{
+    void* new_bp;
+    void* base;
+    size_t old_size;
+
+    if (ptr == NULL) {
+        return malloc(size);
+    }
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    if (in_mm && !is_boot(ptr)) { // 변형 안에서는 부트스트랩 블록만
+        return NULL;
+    }
+    if (is_boot(ptr) || (__atomic_load_n(&table_live, __ATOMIC_RELAXED) > 0 && table_take(ptr, 0) != NULL)) {
+        // 부트스트랩 블록이나 정렬 블록은 새로 받아서 복사
+        if ((new_bp = malloc(size)) == NULL) {
+            return NULL;
+        }
+        if (is_boot(ptr)) {
+            old_size = boot_size(ptr);
+        }
+        else {
+            base = table_take(ptr, 0);
+            lock();
+            old_size = usable_size(base) - ((char*)ptr - (char*)base);
+            unlock();
+        }
+        memcpy(new_bp, ptr, old_size < size ? old_size : size);
+        free(ptr);
+        return new_bp;
+    }
+    lock();
+    new_bp = mm_realloc(ptr, size);
+    unlock();
+    if (new_bp == NULL) {
+        errno = ENOMEM;
+    }
+    return new_bp;
+}
+
+EXPORT size_t malloc_usable_size(void* ptr)
+{
+    void* base;
+    size_t size;
+
+    if (ptr == NULL) {
+        return 0;
+    }
+    if (is_boot(ptr)) {
+        return boot_size(ptr);
+    }
+    base = (__atomic_load_n(&table_live, __ATOMIC_RELAXED) > 0) ? table_take(ptr, 0) : NULL;
+    lock();
+    size = (base != NULL) ? usable_size(base) - ((char*)ptr - (char*)base) : usable_size(ptr);
+    unlock();
+    return size;
+}
+
+// aligned_malloc : align 의 배수 주소 (align 은 2의 거듭제곱)
+static void* aligned_malloc(size_t align, size_t size)
+{
+    char* base;
+    char* bp;
+
+    if (align <= MM_ALIGN) {
+        return malloc(size);
+    }
+    if (in_mm) { // 부트스트랩 버퍼는 16 정렬까지
+        return (align <= BOOT_ALIGN) ? boot_malloc(size) : NULL;
+    }
+    if (mm_memalign != NULL) { // 변형이 정렬 할당을 직접 지원
+        lock();
+        bp = mm_memalign(align, size > 0 ? size : 1);
+        unlock();
+        return bp;
+    }
+    if (size > (size_t)-1 - align) {
+        return NULL;
+    }
+    // 크게 받아서 안쪽 정렬 주소, 원래 주소는 표에
+    if ((base = malloc(size + align)) == NULL) {
+        return NULL;
+    }
+    bp = (char*)(((uintptr_t)base + align - 1) & ~(uintptr_t)(align - 1));
+    if (bp != base && table_put(bp, base) == -1) {
+        free(base);
+        return NULL;
+    }
+    return bp;
+}
+
+EXPORT int posix_memalign(void** memptr, size_t align, size_t size)
+{
+    void* bp;
+
+    if (align < sizeof(void*) || (align & (align - 1)) != 0) {
+        return EINVAL;
+    }
+    if ((bp = aligned_malloc(align, size)) == NULL) {
+        return ENOMEM;
+    }
+    *memptr = bp;
+    return 0;
+}
+
+EXPORT void* aligned_alloc(size_t align, size_t size)
+{
+    if (align == 0 || (align & (align - 1)) != 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return aligned_malloc(align, size);
+}
+
+EXPORT void* memalign(size_t align, size_t size)
+{
+    if (align == 0 || (align & (align - 1)) != 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return aligned_malloc(align, size);
+}
+
+EXPORT void* valloc(size_t size)
+{
+    return aligned_malloc((size_t)getpagesize(), size);
+}
+
+EXPORT void* pvalloc(size_t size)
+{
+    size_t page = (size_t)getpagesize();
+
+    return aligned_malloc(page, (size + page - 1) & ~(page - 1));
+}
+
+// table_put : 정렬 주소 -> 원래 주소 기록 (반 넘게 차면 두 배로 다시 만들기)
+static int table_put(void* ptr, void* base)
+{
+    uintptr_t key = (uintptr_t)ptr;
+    size_t i;
+
+    pthread_mutex_lock(&table_lock);
+    if ((table_used + 1) * 2 > table_cap) {
+        size_t cap = (table_cap == 0) ? TABLE_MIN : ((table_live + 1) * 4 > table_cap ? table_cap * 2 : table_cap);
+        table_slot_t* t = mmap(NULL, cap * sizeof(table_slot_t), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (t == MAP_FAILED) {
+            pthread_mutex_unlock(&table_lock);
+            return -1;
+        }
+        for (size_t k = 0; k < table_cap; k++) { // 지운 칸은 버리고 옮기기
+            if (table[k].key > TABLE_DEAD) {
+                for (i = TABLE_HASH(table[k].key, cap); t[i].key != TABLE_EMPTY; i = (i + 1) & (cap - 1));
+                t[i] = table[k];
+            }
+        }
+        if (table != NULL) {
+            munmap(table, table_cap * sizeof(table_slot_t));
+        }
+        table = t;
+        table_cap = cap;
+        table_used = table_live;
+    }
+    for (i = TABLE_HASH(key, table_cap); table[i].key > TABLE_DEAD; i = (i + 1) & (table_cap - 1));
+    if (table[i].key == TABLE_EMPTY) {
+        table_used++;
+    }
+    table[i].key = key;
+    table[i].base = base;
+    __atomic_store_n(&table_live, table_live + 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&table_lock);
+    return 0;
+}
+
+// table_take : 정렬 주소면 원래 주소 (remove 면 표에서 지움), 아니면 NULL
+static void* table_take(void* ptr, int remove)
+{
+    uintptr_t key = (uintptr_t)ptr;
+    void* base = NULL;
+
+    pthread_mutex_lock(&table_lock);
+    if (table_cap > 0) {
+        for (size_t i = TABLE_HASH(key, table_cap); table[i].key != TABLE_EMPTY; i = (i + 1) & (table_cap - 1)) {
+            if (table[i].key == key) {
+                base = table[i].base;
+                if (remove) {
+                    table[i].key = TABLE_DEAD;
+                    __atomic_store_n(&table_live, table_live - 1, __ATOMIC_RELAXED);
+                }
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&table_lock);
+    return base;
+}
@@ -1,11 +1,15 @@
 // Segregated List - Worst fit
+// + 크기 클래스마다 정렬 리스트 대신 최대 힙 배열 (가장 큰 블록 O(1), 추가/삭제 O(log n))
 
 
+#define _GNU_SOURCE // mremap
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdint.h>
 
 #include <sys/mman.h>
 #include <errno.h>
@@ -24,8 +28,19 @@
 #define DSIZE       8           
 #define CHUNKSIZE   (1 << 12)   
 
+#define LISTLIMIT   20          // 분리 리스트(크기 클래스) 개수
+#define CLASS_BIT(i)    (1u << (i))   // 리스트 비트맵에서 i번 리스트 비트
+#define CLASS_HEAP_MIN  256         // 클래스별 최대 힙 배열 처음 칸 수 (모자라면 두 배씩 mremap)
+
 #define MAX(x, y)   ((x) > (y) ? (x) : (y))   
 
+/////// quick list : 최근 해제된 작은 블록을 병합 없이 크기별로 모아 두었다가 같은 크기 요청에 바로 재사용
+#define QUICK_MAX   64                      // quick list 로 처리하는 최대 블록 크기
+#define QUICK_LISTS (QUICK_MAX / DSIZE + 1) // 블록 크기 / DSIZE 가 리스트 번호 (정확히 같은 크기만)
+#define QUICK_LIMIT 128                     // 모인 블록 수가 이보다 많아지면 전부 병합 (consolidate)
+
+#define QUICK_NEXT(bp) (*(void**)(bp)) // quick list 안 다음 블록 (할당 상태 블록의 페이로드 첫 칸)
+
 // 정보 (블록 사이즈와 할당 여부에 대한 정보를 헤더와 풋터에 넣어야 함)
 #define PACK(size, alloc)   ((size) | (alloc))
 
@@ -34,6 +49,11 @@
 
 #define GET_SIZE(p)    (GETTER(p) & ~0x7)   // 블록 크기
 #define IS_ALLOCATED(p)   (GETTER(p) & 0x1)  // 블록 할당 여부
+#define IS_PREV_ALLOCATED(p)   (GETTER(p) & 0x2)   // 이전 블록 할당 여부 (헤더에만 기록)
+#define PREV_ALLOC  0x2   // 헤더의 이전 블록 할당 비트
+
+#define SET_PREV_ALLOC(p)   PUTTER(p, GETTER(p) | PREV_ALLOC)   // 이전 블록 할당 표시
+#define CLR_PREV_ALLOC(p)   PUTTER(p, GETTER(p) & ~PREV_ALLOC)  // 이전 블록 프리 표시
 
 #define HDPT(bp)    ((char *)(bp) - WSIZE)  // 헤더 포인터
 #define FTPT(bp)    ((char *)(bp) + GET_SIZE(HDPT(bp)) - DSIZE)  // 풋터 포인터
@@ -41,41 +61,64 @@
 #define NEXT_BLKP(bp)   (((char *)(bp) + GET_SIZE((char *)(bp) - WSIZE)))   // 다음 블록 포인터 
 #define PREV_BLKP(bp)   (((char *)(bp) - GET_SIZE((char *)(bp) - DSIZE)))   // 이전 블록 포인터
 
-#define PRED_FREEPT(bp) (*(void**)(bp)) // 이전 프리블록 포인터
-#define SUCC_FREEPT(bp) (*(void**)(bp + WSIZE)) // 다음 프리블록 포인터
+#define HEAP_INDEX(bp)  (*(unsigned int*)(bp)) // 프리 블록의 클래스 최대 힙 배열 인덱스 (페이로드 첫 워드)
 
 static void* heap_list = NULL; // 힙 리스트 시작 포인터
-static void* segregation_list[LISTLIMIT];
-
-static int mm_init(void);
+static void* quick_list[QUICK_LISTS]; // 크기별 quick list (LIFO)
+static int quick_count; // quick list 에 모인 블록 수
+static void** class_heap[LISTLIMIT]; // 클래스별 프리 블록 최대 힙 배열 (mmap, mm_init 이 다시 불려도 재사용)
+static size_t class_count[LISTLIMIT]; // 클래스별 힙에 든 블록 수
+static size_t class_cap[LISTLIMIT]; // 클래스별 배열 칸 수
+static unsigned int list_bitmap; // 비어있지 않은 클래스 비트맵
+
+int mm_init(void);
 static void* extend_heap(size_t words);
 static void* coalesce(void* bp);
 void* mm_malloc(size_t size);
-static void* best_fit(size_t a_size);
+static void* worst_fit(size_t a_size);
 static void place(void* bp, size_t a_size);
 void mm_free(void* bp);
+static void free_block(void* bp);
+static void consolidate(void);
 void* mm_realloc(void* bp, size_t size);
+void* mm_memalign(size_t alignment, size_t size);
+void* mm_aligned_alloc(size_t alignment, size_t size);
+static void* aligned_fit(size_t alignment, size_t a_size);
+static char* aligned_payload(void* bp, size_t alignment);
+static void* place_aligned(void* bp, size_t alignment, size_t a_size);
 
 
+static int list_index(size_t size);
 static void remove_block(void* bp);
 static void insert_block(void* bp, size_t size);
+static int class_reserve(size_t incr);
+static void class_up(int c, size_t i);
+static void class_down(int c, size_t i);
 
 // mm_init
 int mm_init(void)
 {
+    for (int i = 0; i < QUICK_LISTS; i++) { // quick list 비우기
+        quick_list[i] = NULL;
+    }
+    quick_count = 0;
+
+    for (int i = 0; i < LISTLIMIT; i++) { // 클래스별 힙 비우기
+        class_count[i] = 0;
+    }
+    list_bitmap = 0;
+
     // 메모리 확장 실패
-    if ((heap_list = mem_sbrk(6 * WSIZE)) == (void*)-1) {
+    if ((heap_list = mem_sbrk(4 * WSIZE)) == (void*)-1) {
         return -1;
     }
 
     PUTTER(heap_list, 0);                             // 시작 부분
-    PUTTER(heap_list + (1 * WSIZE), PACK(2 * DSIZE, 1)); // 맨 앞 헤더 할당된 것
-    PUTTER(heap_list + (2 * WSIZE), NULL);            // 이전 포인터 null
-    PUTTER(heap_list + (3 * WSIZE), NULL);            // 이후 포인터 null
-    PUTTER(heap_list + (4 * WSIZE), PACK(2 * DSIZE, 1));  // 풋터 
-    PUTTER(heap_list + (5 * WSIZE), PACK(0, 1));      // 뒷부분 헤더
+    PUTTER(heap_list + (1 * WSIZE), PACK(DSIZE, 1));  // 맨 앞 헤더 할당된 것
+    PUTTER(heap_list + (2 * WSIZE), PACK(DSIZE, 1));  // 풋터
+    PUTTER(heap_list + (3 * WSIZE), PACK(0, 1) | PREV_ALLOC);      // 뒷부분 헤더
 
-    free_list = heap_list + (2 * WSIZE); // 프리 블록 리스트의 시작을 맨 앞 다음 첫 프리블록으로
+    heap_list += (2 * WSIZE); // 힙 리스트의 포인터를 맨 앞 블록의 끝으로
 
     if (extend_heap(CHUNKSIZE / WSIZE) == NULL) // 확장 ~
         return -1;
@@ -90,11 +133,11 @@ static void* extend_heap(size_t words) {
 
     // 짝수 개의 단어로 크기 조정
     size = (words % 2) ? (words + 1) * WSIZE : words * WSIZE;
-    if ((long)(bp = mem_sbrk(size)) == -1) // 메모리 할당 실패 시
+    if (class_reserve(size) == -1 || (long)(bp = mem_sbrk(size)) == -1) // 메모리 할당 실패 시 (클래스 힙 배열도 함께 확보)
         return NULL;
 
     // 프리 블록 헤더/풋터와 새로운 에필로그 헤더 초기화
-    PUTTER(HDPT(bp), PACK(size, 0)); // 프리 블록 헤더
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp))); // 프리 블록 헤더
     PUTTER(FTPT(bp), PACK(size, 0)); // 프리 블록 풋터
     PUTTER(HDPT(NEXT_BLKP(bp)), PACK(0, 1)); // 새로운 에필로그 헤더
 
@@ -104,94 +147,215 @@ static void* extend_heap(size_t words) {
 
 // coalesce
 static void* coalesce(void* bp) {
-    size_t prev_alloc = IS_ALLOCATED(FTPT(PREV_BLKP(bp))); // 이전 블록 할당 여부
+    size_t prev_alloc = IS_PREV_ALLOCATED(HDPT(bp)); // 이전 블록 할당 여부
     size_t next_alloc = IS_ALLOCATED(HDPT(NEXT_BLKP(bp))); // 다음 블록 할당 여부
     size_t size = GET_SIZE(HDPT(bp)); // 현재 블록 크기
 
     if (prev_alloc && next_alloc) { // 이전과 다음 블록 모두 할당된 경우
+        insert_block(bp, size); // 리스트에 추가
         return bp;
     }
 
     else if (prev_alloc && !next_alloc) { // 다음 블록만 프리 상태인 경우
+        remove_block(NEXT_BLKP(bp)); // 다음 블록 리스트에서 제거
         size += GET_SIZE(HDPT(NEXT_BLKP(bp))); // 다음 블록 크기 추가
-        PUTTER(HDPT(bp), PACK(size, 0)); // 현재 블록 헤더 갱신
+        PUTTER(HDPT(bp), PACK(size, 0) | PREV_ALLOC); // 현재 블록 헤더 갱신
         PUTTER(FTPT(bp), PACK(size, 0)); // 현재 블록 풋터 갱신
     }
 
     else if (!prev_alloc && next_alloc) { // 이전 블록만 프리 상태인 경우
+        remove_block(PREV_BLKP(bp)); // 이전 블록 리스트에서 제거
         size += GET_SIZE(HDPT(PREV_BLKP(bp))); // 이전 블록 크기 추가
         PUTTER(FTPT(bp), PACK(size, 0)); // 현재 블록 풋터 갱신
-        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0)); // 이전 블록 헤더 갱신
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC); // 이전 블록 헤더 갱신
         bp = PREV_BLKP(bp); // 블록 포인터 이전 블록으로 이동
     }
 
     else { // 이전과 다음 블록 모두 프리 상태인 경우
+        remove_block(PREV_BLKP(bp)); // 이전 블록 리스트에서 제거
+        remove_block(NEXT_BLKP(bp)); // 다음 블록 리스트에서 제거
         size += GET_SIZE(HDPT(PREV_BLKP(bp))) + GET_SIZE(HDPT(NEXT_BLKP(bp))); // 이전과 다음 블록 크기 추가
-        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0)); // 이전 블록 헤더 갱신
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC); // 이전 블록 헤더 갱신
         PUTTER(FTPT(NEXT_BLKP(bp)), PACK(size, 0)); // 다음 블록 풋터 갱신
         bp = PREV_BLKP(bp); // 블록 포인터 이전 블록으로 이동
     }
 
+    insert_block(bp, size); // 통합된 블록 리스트에 추가
     return bp; // 통합된 블록 반환
 }
 
-// worst_fit
+// mm_malloc 
+void* mm_malloc(size_t size) {
+    size_t a_size; // 실제로 할당할 블록 크기
+    size_t extend_size; // 힙을 확장할 크기
+    char* bp; // 찾은 프리 블록의 시작 주소
+
+    if (size == 0) { // 요청하는 크기가 0이면 할당 불필요
+        return NULL;
+    }
+
+    // 할당할 프리블록 찾기
+    if (size <= DSIZE + WSIZE) { // 최소 블록 크기 이하로 요청 받은 경우 최소 크기 블록으로 할당
+        a_size = 2 * DSIZE;
+    }
+    else { // 요청보다 더 크게 할당
+        // 할당 블록은 헤더만 있으므로 size + WSIZE
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
+    }
+
+    // 같은 크기 블록이 quick list 에 있으면 병합/탐색 없이 바로 (LIFO)
+    if (a_size <= QUICK_MAX && quick_list[a_size / DSIZE] != NULL) {
+        bp = quick_list[a_size / DSIZE];
+        quick_list[a_size / DSIZE] = QUICK_NEXT(bp);
+        quick_count--;
+        return bp;
+    }
+
+    // 적절한 프리 블록 탐색, 못 찾으면 quick list 블록들을 병합하고 한 번 더
+    bp = worst_fit(a_size);
+    if (bp == NULL && quick_count > 0) {
+        consolidate();
+        bp = worst_fit(a_size);
+    }
+    if (bp != NULL) {
+        place(bp, a_size);
+        return bp;  // 프리 블록 적절한 것 발견했다면 return 후 종료
+    }
+    // 적절한 프리블록을 못 찾았다면
+    extend_size = MAX(a_size, CHUNKSIZE);  // 요청 크기와 기본 크기 중 큰 값으로 확장
+    if ((bp = extend_heap(extend_size / WSIZE)) == NULL) { // 정해진 크기로 힙 확장 
+        return NULL; // 실패하면 -1 NULL
+    }
+    place(bp, a_size);  // bp 에는 함수를 통해 프리 블록 할당
+    return bp;  // 성공하면 블록 시작 주소 리턴
+}
+
+// worst_fit : 가장 큰 비어있지 않은 클래스의 최대 힙 맨 위
 static void* worst_fit(size_t a_size) {
     void* bp; // 블록 포인터
-    void* worst_bp = NULL; // worst 블록 포인터 초기화
-    size_t worst_size = 0; // worst 크기를 0으로 초기화
-    for (int i = 0; i < LISTLIMIT; i++) { // 각 리스트 탐색
-        for (bp = segregation_list[i]; bp != NULL; bp = SUCC_FREE(bp)) { // 각 블록 탐색
-            size_t size = GET_SIZE(HDPT(bp)); // 현재 블록 크기
-            if (a_size <= size && size > worst_size) { // 요청 크기보다 크고 worst 크기보다 큰 경우
-                worst_size = size; // worst 크기 갱신
-                worst_bp = bp; // worst 블록 포인터 갱신
-            }
-        }
+    int i; // 가장 큰 비어있지 않은 클래스
+
+    if (list_bitmap == 0) {
+        return NULL;
     }
-    return worst_bp; // worst 블록 포인터 반환
+    i = 31 - __builtin_clz(list_bitmap);
+
+    bp = class_heap[i][0]; // 클래스 안에서 가장 큰 블록
+    return (a_size <= GET_SIZE(HDPT(bp))) ? bp : NULL; // worst 블록 포인터 반환
 }
 
 // place
 static void place(void* bp, size_t a_size) {
     size_t csize = GET_SIZE(HDPT(bp)); // 현재 블록 크기
 
+    remove_block(bp); // 할당할 블록이므로 리스트에서 제거
+
     if ((csize - a_size) >= (2 * DSIZE)) { // 블록 분할 가능한 경우
-        PUTTER(HDPT(bp), PACK(a_size, 1)); // 블록 할당 헤더 설정
-        PUTTER(FTPT(bp), PACK(a_size, 1)); // 블록 할당 풋터 설정
+        PUTTER(HDPT(bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(bp))); // 블록 할당 헤더 설정
         bp = NEXT_BLKP(bp); // 블록 포인터 이동
-        PUTTER(HDPT(bp), PACK(csize - a_size, 0)); // 분할된 프리 블록 헤더 설정
+        PUTTER(HDPT(bp), PACK(csize - a_size, 0) | PREV_ALLOC); // 분할된 프리 블록 헤더 설정
         PUTTER(FTPT(bp), PACK(csize - a_size, 0)); // 분할된 프리 블록 풋터 설정
         insert_block(bp, csize - a_size); // 프리 블록 리스트에 추가
     }
     else { // 블록 분할 불가능한 경우
-        PUTTER(HDPT(bp), PACK(csize, 1)); // 전체 블록 할당 헤더 설정
-        PUTTER(FTPT(bp), PACK(csize, 1)); // 전체 블록 할당 풋터 설정
+        PUTTER(HDPT(bp), PACK(csize, 1) | IS_PREV_ALLOCATED(HDPT(bp))); // 전체 블록 할당 헤더 설정
+        SET_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 할당 블록은 풋터 없이 다음 블록 헤더에 표시
     }
 }
 
-// mm_free
+// mm_free : 작은 블록은 할당 상태 그대로 quick list 에 넣고 병합은 미룸
 void mm_free(void* bp)
+{
+    size_t size = GET_SIZE(HDPT(bp)); // 블록 크기
+
+    if (size <= QUICK_MAX) {
+        QUICK_NEXT(bp) = quick_list[size / DSIZE];
+        quick_list[size / DSIZE] = bp;
+        if (++quick_count > QUICK_LIMIT) { // 너무 많이 모였으면 한꺼번에 병합
+            consolidate();
+        }
+        return;
+    }
+    free_block(bp);
+}
+
+// consolidate : quick list 블록을 전부 실제로 해제하고 병합
+static void consolidate(void) {
+    void* bp;
+
+    for (int i = 0; i < QUICK_LISTS; i++) {
+        while ((bp = quick_list[i]) != NULL) {
+            quick_list[i] = QUICK_NEXT(bp);
+            free_block(bp);
+        }
+    }
+    quick_count = 0;
+}
+
+// free_block : 프리 블록으로 바꾸고 이웃과 병합
+static void free_block(void* bp)
 {
     size_t size = GET_SIZE(HDPT(bp)); // 블록 해제를 위해 매개변수 받기
 
-    PUTTER(HDPT(bp), PACK(size, 0)); // 프리블록으로 상태 변경
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp))); // 프리블록으로 상태 변경
     PUTTER(FTPT(bp), PACK(size, 0));
+    CLR_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 다음 블록에 이전 블록 프리 표시
     coalesce(bp); // 프리 블록 병합
 }
 
-// mm_realloc
+// mm_realloc : 뒤 블록이 프리거나 힙 끝이면 제자리에서 늘리고, 줄일 때는 뒷부분을 돌려줌
 void* mm_realloc(void* bp, size_t size)
 {
     void* old_bp = bp; // 기존 블록 포인터
     void* new_bp;  // 새로 할당되는 블록 할당 포인터
     size_t copySize; // 복사 데이터 크기
+    size_t a_size; // 새로 필요한 블록 크기
+    size_t c_size = GET_SIZE(HDPT(old_bp)); // 기존 블록 크기
+    size_t n_size = c_size; // 제자리에서 쓸 수 있는 크기
+    void* next_bp = NEXT_BLKP(old_bp); // 다음 블록
+
+    if (size <= DSIZE + WSIZE) { // mm_malloc 과 같은 방식으로 블록 크기 계산
+        a_size = 2 * DSIZE;
+    }
+    else {
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
+    }
+
+    // 다음 블록이 프리면 합쳐서 쓸 수 있음
+    if (!IS_ALLOCATED(HDPT(next_bp))) {
+        n_size += GET_SIZE(HDPT(next_bp));
+    }
+    // 그래도 모자라는데 힙의 마지막 블록이면 모자란 만큼만 힙 확장
+    if (n_size < a_size && GET_SIZE(HDPT((char*)old_bp + n_size)) == 0
+        && class_reserve(a_size - n_size) == 0 && (long)mem_sbrk(a_size - n_size) != -1) {
+        n_size = a_size;
+        PUTTER(HDPT((char*)old_bp + n_size), PACK(0, 1)); // 새 에필로그 헤더
+    }
+
+    if (n_size >= a_size) { // 제자리에서 늘리거나 줄이기
+        if (n_size != c_size && !IS_ALLOCATED(HDPT(next_bp))) { // 합칠 다음 블록은 프리 리스트에서 제거
+            remove_block(next_bp);
+        }
+        if ((n_size - a_size) >= (2 * DSIZE)) { // 남는 부분이 최소 블록 이상이면 떼어서 프리 블록으로
+            PUTTER(HDPT(old_bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(old_bp)));
+            next_bp = NEXT_BLKP(old_bp);
+            PUTTER(HDPT(next_bp), PACK(n_size - a_size, 0) | PREV_ALLOC);
+            PUTTER(FTPT(next_bp), PACK(n_size - a_size, 0));
+            CLR_PREV_ALLOC(HDPT(NEXT_BLKP(next_bp)));
+            coalesce(next_bp); // 그 뒤 블록이 프리면 합쳐짐
+        }
+        else {
+            PUTTER(HDPT(old_bp), PACK(n_size, 1) | IS_PREV_ALLOCATED(HDPT(old_bp)));
+            SET_PREV_ALLOC(HDPT(NEXT_BLKP(old_bp)));
+        }
+        return old_bp;
+    }
 
     new_bp = mm_malloc(size); // 새 블록 할당
 
     if (new_bp == NULL) return NULL;
 
-    copySize = GET_SIZE(HDPT(old_bp)); // 기존 블록 크기
+    copySize = c_size - WSIZE; // 기존 블록 페이로드 크기
 
     if (size < copySize) // 재할당할 크기가 기존보다 작으면
         copySize = size; // 원래 size만큼조정
@@ -204,68 +368,207 @@ void* mm_realloc(void* bp, size_t size)
     return new_bp; // 실패시 블록 할당 역할
 }
 
-// remove_block
-static void remove_block(void* bp) {
-    int i = 0; // 리스트 인덱스
-    size_t size = GET_SIZE(HDPT(bp)); // 블록 크기
+// mm_memalign : alignment (2의 거듭제곱) 배수 주소의 페이로드
+// 정렬된 페이로드가 들어가는 프리 블록을 찾아 앞 조각은 프리 블록으로 떼어 내고, 뒷부분은 place 가 분할
+void* mm_memalign(size_t alignment, size_t size)
+{
+    size_t a_size; // 실제로 할당할 블록 크기
+    size_t extend_size; // 힙을 확장할 크기
+    char* bp; // 정렬된 페이로드를 담을 프리 블록
 
-    while ((i < LISTLIMIT - 1) && (size > 1)) { // 적절한 리스트 인덱스 찾기
-        size >>= 1;
-        i++;
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) { // 2의 거듭제곱만
+        errno = EINVAL;
+        return NULL;
+    }
+    if (alignment <= DSIZE) { // 기본 정렬로 충분
+        return mm_malloc(size);
+    }
+    if (size == 0) {
+        return NULL;
     }
 
-    if (SUCC_FREEPT(bp) != NULL) { // 다음 블록이 존재하는 경우
-        PRED_FREEPT(SUCC_FREEPT(bp)) = PRED_FREEPT(bp); // 이전 블록 연결 갱신
+    if (size <= DSIZE + WSIZE) { // mm_malloc 과 같은 방식으로 블록 크기 계산
+        a_size = 2 * DSIZE;
+    }
+    else {
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
     }
-    if (PRED_FREEPT(bp) != NULL) { // 이전 블록이 존재하는 경우
-        SUCC_FREEPT(PRED_FREEPT(bp)) = SUCC_FREEPT(bp); // 다음 블록 연결 갱신
+
+    // 정렬된 페이로드가 들어가는 프리 블록 탐색, 못 찾으면 quick list 블록들을 병합하고 한 번 더
+    bp = aligned_fit(alignment, a_size);
+    if (bp == NULL && quick_count > 0) {
+        consolidate();
+        bp = aligned_fit(alignment, a_size);
     }
-    else { // 현재 블록이 리스트의 첫 블록인 경우
-        segregation_list[i] = SUCC_FREEPT(bp); // 리스트 헤더 갱신
+    if (bp == NULL) { // 어느 주소에서 시작해도 정렬된 페이로드가 들어가는 크기로 힙 확장
+        extend_size = MAX(a_size + alignment + 2 * DSIZE, CHUNKSIZE);
+        if ((bp = extend_heap(extend_size / WSIZE)) == NULL) {
+            return NULL;
+        }
     }
+    return place_aligned(bp, alignment, a_size);
 }
 
-// insert_block
-static void insert_block(void* bp, size_t size) {
-    int i = 0; // 리스트 인덱스
-    void* search_bp = NULL; // 검색 블록 포인터
-    void* insert_bp = NULL; // 삽입 위치 블록 포인터
+// mm_aligned_alloc : C11 aligned_alloc 과 같은 모양
+void* mm_aligned_alloc(size_t alignment, size_t size)
+{
+    return mm_memalign(alignment, size);
+}
+
+// aligned_fit : 정렬된 페이로드 + a_size 가 들어가는 프리 블록
+// 가장 큰 블록이 맞으면 그 블록 (worst fit), 아니면 큰 클래스부터 클래스 힙 배열을 훑어서 처음 맞는 블록
+static void* aligned_fit(size_t alignment, size_t a_size) {
+    void* bp; // 블록 포인터
+    int i; // 클래스
+    unsigned int map = list_bitmap & ~(CLASS_BIT(list_index(a_size)) - 1); // 요청 클래스 이상 비어있지 않은 클래스들
+
+    if (map == 0) {
+        return NULL;
+    }
+    bp = class_heap[31 - __builtin_clz(list_bitmap)][0]; // 가장 큰 블록
+    if (aligned_payload(bp, alignment) + a_size <= (char*)bp + GET_SIZE(HDPT(bp))) {
+        return bp;
+    }
+    for (; map != 0; map &= ~CLASS_BIT(i)) {
+        i = 31 - __builtin_clz(map);
+        for (size_t k = 0; k < class_count[i]; k++) {
+            bp = class_heap[i][k];
+            if (aligned_payload(bp, alignment) + a_size <= (char*)bp + GET_SIZE(HDPT(bp))) {
+                return bp;
+            }
+        }
+    }
+    return NULL;
+}
 
-    while ((i < LISTLIMIT - 1) && (size > 1)) { // 적절한 리스트 인덱스 찾기
-        size >>= 1;
-        i++;
+// aligned_payload : 프리 블록 bp 안에서 처음으로 정렬되는 페이로드 주소 (앞 조각은 없거나 최소 블록 이상)
+static char* aligned_payload(void* bp, size_t alignment) {
+    char* p = (char*)(((uintptr_t)bp + alignment - 1) & ~(uintptr_t)(alignment - 1));
+
+    if (p != (char*)bp && p - (char*)bp < 2 * DSIZE) { // 앞 조각이 최소 블록보다 작으면 다음 정렬 주소
+        p += alignment;
     }
+    return p;
+}
 
-    search_bp = segregation_list[i]; // 리스트 헤더로부터 검색 시작
-    while ((search_bp != NULL) && (size > GET_SIZE(HDPT(search_bp)))) { // 적절한 위치 찾기
-        insert_bp = search_bp;
-        search_bp = SUCC_FREEPT(search_bp);
+// place_aligned : 정렬된 자리 앞 조각을 프리 블록으로 떼어 내고 정렬된 자리에서 place
+static void* place_aligned(void* bp, size_t alignment, size_t a_size) {
+    char* p = aligned_payload(bp, alignment); // 정렬된 페이로드
+    size_t c_size = GET_SIZE(HDPT(bp)); // 현재 블록 크기
+    size_t lead = p - (char*)bp; // 앞 조각 크기
+
+    if (lead > 0) {
+        remove_block(bp);
+        // 앞 조각 : 프리 블록의 앞 블록은 항상 할당 상태이므로 병합할 것 없음
+        PUTTER(HDPT(bp), PACK(lead, 0) | IS_PREV_ALLOCATED(HDPT(bp)));
+        PUTTER(FTPT(bp), PACK(lead, 0));
+        insert_block(bp, lead);
+        // 정렬된 자리부터 나머지 (앞 블록은 프리)
+        PUTTER(HDPT(p), PACK(c_size - lead, 0));
+        PUTTER(FTPT(p), PACK(c_size - lead, 0));
+        insert_block(p, c_size - lead);
     }
+    place(p, a_size); // 뒷부분은 최소 블록 이상이면 분할
+    return p;
+}
+
+// list_index : 블록 크기에 맞는 분리 리스트 번호
+static int list_index(size_t size) {
+    int i = 31 - __builtin_clz((unsigned int)size | 1); // 최상위 비트 위치 = floor(log2(size))
+
+    return (i < LISTLIMIT - 1) ? i : LISTLIMIT - 1; // 큰 블록은 마지막 리스트로
+}
+
+// remove_block : 클래스 힙의 마지막 블록을 bp 자리로 옮기고 위나 아래로
+static void remove_block(void* bp) {
+    int c = list_index(GET_SIZE(HDPT(bp))); // 클래스
+    size_t i = HEAP_INDEX(bp); // bp 자리
+    void* last = class_heap[c][--class_count[c]]; // 마지막 블록
+
+    if (class_count[c] == 0) { // 클래스가 비면 비트맵에서 지우기
+        list_bitmap &= ~CLASS_BIT(c);
+    }
+    if (i == class_count[c]) { // bp 가 마지막이었으면 끝
+        return;
+    }
+    class_heap[c][i] = last;
+    HEAP_INDEX(last) = i;
+    class_up(c, i);
+    class_down(c, HEAP_INDEX(last));
+}
+
+// insert_block : 클래스 힙 맨 끝에 넣고 위로
+static void insert_block(void* bp, size_t size) {
+    int c = list_index(size); // 클래스
+
+    list_bitmap |= CLASS_BIT(c); // 비어있지 않은 클래스로 표시
+    class_heap[c][class_count[c]] = bp;
+    class_up(c, class_count[c]++);
+}
 
-    if (search_bp != NULL) { // 삽입 위치가 리스트 중간인 경우
-        if (insert_bp != NULL) { // 삽입 위치가 리스트 중간인 경우
-            SUCC_FREEPT(insert_bp) = bp;
-            PRED_FREEPT(search_bp) = bp;
-            SUCC_FREEPT(bp) = search_bp;
-            PRED_FREEPT(bp) = insert_bp;
+// class_reserve : 힙이 incr 만큼 늘어도 모든 프리 블록이 클래스 배열에 들어가도록 미리 늘림
+// 프리 블록은 서로 붙어 있지 않으므로 c 클래스 블록은 (클래스 최소 크기 + 할당 블록) 마다 많아야 하나
+static int class_reserve(size_t incr) {
+    size_t heap_size = mem_heapsize() + incr; // 늘어난 뒤 힙 크기
+    size_t need; // 필요한 칸 수
+    size_t cap; // 새 칸 수
+    void* p;
+
+    for (int c = 0; c < LISTLIMIT; c++) {
+        need = heap_size / (MAX((size_t)1 << c, 2 * DSIZE) + 2 * DSIZE) + 2;
+        if (need <= class_cap[c]) {
+            continue;
+        }
+        for (cap = (class_cap[c] != 0) ? class_cap[c] : CLASS_HEAP_MIN; cap < need; cap *= 2)
+            ;
+        if (class_heap[c] == NULL) {
+            p = mmap(NULL, cap * sizeof(void*), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
         }
-        else { // 삽입 위치가 리스트의 첫 블록인 경우
-            SUCC_FREEPT(bp) = search_bp;
-            PRED_FREEPT(search_bp) = bp;
-            PRED_FREEPT(bp) = NULL;
-            segregation_list[i] = bp;
+        else { // 페이지를 옮기므로 memcpy 없음
+            p = mremap(class_heap[c], class_cap[c] * sizeof(void*), cap * sizeof(void*), MREMAP_MAYMOVE);
         }
+        if (p == MAP_FAILED) {
+            return -1;
+        }
+        class_heap[c] = p;
+        class_cap[c] = cap;
     }
-    else { // 삽입 위치가 리스트의 끝인 경우
-        if (insert_bp != NULL) { // 삽입 위치가 리스트 중간인 경우
-            SUCC_FREEPT(insert_bp) = bp;
-            PRED_FREEPT(bp) = insert_bp;
-            SUCC_FREEPT(bp) = NULL;
+    return 0;
+}
+
+// class_up : 부모보다 크면 부모와 자리 바꾸기
+static void class_up(int c, size_t i) {
+    void** h = class_heap[c];
+    void* bp = h[i];
+    size_t size = GET_SIZE(HDPT(bp));
+
+    while (i > 0 && GET_SIZE(HDPT(h[(i - 1) / 2])) < size) {
+        h[i] = h[(i - 1) / 2]; // 부모를 아래로
+        HEAP_INDEX(h[i]) = i;
+        i = (i - 1) / 2;
+    }
+    h[i] = bp;
+    HEAP_INDEX(bp) = i;
+}
+
+// class_down : 더 큰 자식보다 작으면 자식과 자리 바꾸기
+static void class_down(int c, size_t i) {
+    void** h = class_heap[c];
+    void* bp = h[i];
+    size_t size = GET_SIZE(HDPT(bp));
+    size_t k; // 더 큰 자식
+
+    while ((k = 2 * i + 1) < class_count[c]) {
+        if (k + 1 < class_count[c] && GET_SIZE(HDPT(h[k + 1])) > GET_SIZE(HDPT(h[k]))) {
+            k++;
         }
-        else { // 삽입 위치가 리스트의 첫 블록인 경우
-            SUCC_FREEPT(bp) = NULL;
-            PRED_FREEPT(bp) = NULL;
-            segregation_list[i] = bp;
+        if (GET_SIZE(HDPT(h[k])) <= size) {
+            break;
         }
+        h[i] = h[k]; // 자식을 위로
+        HEAP_INDEX(h[i]) = i;
+        i = k;
     }
+    h[i] = bp;
+    HEAP_INDEX(bp) = i;
 }
@@ -1,4 +1,16 @@
 // Segregated List - First fit
+// + 스레드별 캐시(tcache) : 작은 블록은 공유 리스트를 거치지 않고 스레드 안에서 재사용
+// + 아레나 : 스레드마다 독립된 힙(분리 리스트, 프롤로그/에필로그, 확장)을 나눠 씀
+// + slab : 256바이트 이하 요청은 헤더/풋터 없이 1KB run 의 같은 크기 슬롯에서 O(1) 할당
+// + 큰 블록 : 임계값 이상 요청은 전용 mmap 으로 주고 munmap/mremap 으로 반환/크기 조정 (더블 워드 헤더라 4GB 넘는 블록도)
+// + 반환 : 오래 쓰이지 않은 큰 프리 블록 안쪽 페이지는 madvise 로 OS 에 돌려주고, 힙 끝 프리 블록은 잘라냄
+// + 빌드 옵션 -DNEXT_FIT : 클래스마다 지난번에 찾은 블록 다음(rover)부터 탐색하는 next fit
+// + 빌드 옵션 -DADDRESS_ORDERED : 클래스 리스트를 크기순 대신 주소순으로 (칸별 첫 블록 인덱스로 넣을 자리 찾기)
+// + mm_free_sized : 호출자가 준 요청 크기로 헤더를 읽지 않고 캐시 칸을 골라 해제, 다시 꺼낼 때도 헤더를 읽지 않음 (-DCHECK_SIZED 로 헤더와 대조)
+// + mm_footprint : mem_sbrk 힙 밖(mmap 아레나, slab, mmap 블록)까지 더한 사용 중인 주소 공간 (벤치 사용률 계산용)
+// + mm_atfork_prepare/parent/child : fork 동안 모든 락을 잡아 두고 자식에서는 다시 초기화 (preload 의 atfork 에서 부름)
+
+#define _GNU_SOURCE // mremap
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,6 +20,9 @@
 
 #include <sys/mman.h>
 #include <errno.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "mm.h"
 #include "memlib.h"
@@ -19,11 +34,14 @@
 #define SIZE_T_SIZE (ALIGN(sizeof(size_t)))
 
 /////// 워드, 헤더, 푸터 / 더블 워드 / 힙 확장 기본 바이트
-#define WSIZE       4           
-#define DSIZE       8           
-#define CHUNKSIZE   (1 << 12)   
+#define WSIZE       4
+#define DSIZE       8
+#define CHUNKSIZE   (1 << 12)
+
+#define LISTLIMIT   20          // 분리 리스트(크기 클래스) 개수
+#define CLASS_BIT(i)    (1u << (i))   // 리스트 비트맵에서 i번 리스트 비트
 
-#define MAX(x, y)   ((x) > (y) ? (x) : (y))   
+#define MAX(x, y)   ((x) > (y) ? (x) : (y))
 
 // 정보 (블록 사이즈와 할당 여부에 대한 정보를 헤더와 풋터에 넣어야 함)
 #define PACK(size, alloc)   ((size) | (alloc))
@@ -33,111 +51,467 @@
 
 #define GET_SIZE(p)    (GETTER(p) & ~0x7)   // 블록 크기
 #define IS_ALLOCATED(p)   (GETTER(p) & 0x1)  // 블록 할당 여부
+#define IS_PREV_ALLOCATED(p)   (GETTER(p) & 0x2)   // 이전 블록 할당 여부 (헤더에만 기록)
+#define PREV_ALLOC  0x2   // 헤더의 이전 블록 할당 비트
+
+#define SET_PREV_ALLOC(p)   PUTTER(p, GETTER(p) | PREV_ALLOC)   // 이전 블록 할당 표시
+#define CLR_PREV_ALLOC(p)   PUTTER(p, GETTER(p) & ~PREV_ALLOC)  // 이전 블록 프리 표시
 
 #define HDPT(bp)    ((char *)(bp) - WSIZE)  // 헤더 포인터
 #define FTPT(bp)    ((char *)(bp) + GET_SIZE(HDPT(bp)) - DSIZE)  // 풋터 포인터
 
-#define NEXT_BLKP(bp)   (((char *)(bp) + GET_SIZE((char *)(bp) - WSIZE)))   // 다음 블록 포인터 
+#define NEXT_BLKP(bp)   (((char *)(bp) + GET_SIZE((char *)(bp) - WSIZE)))   // 다음 블록 포인터
 #define PREV_BLKP(bp)   (((char *)(bp) - GET_SIZE((char *)(bp) - DSIZE)))   // 이전 블록 포인터
 
-#define PRED_FREEPT(bp) (*(void**)(bp)) // 이전 프리블록 포인터
-#define SUCC_FREEPT(bp) (*(void**)(bp + WSIZE)) // 다음 프리블록 포인터
+// 프리 블록 링크는 포인터 대신 아레나 heap_list 로부터의 오프셋 / DSIZE 를 한 워드에 (0 은 NULL, 리스트는 아레나별이라 같은 아레나 안)
+// 64비트에서도 최소 블록 16바이트 (헤더 + 이전 + 다음 + 풋터) 그대로, 대신 0번 아레나 힙은 32GB (2^32 * DSIZE) 까지
+#define TO_LINK(ar, p)      ((p) == NULL ? 0u : (unsigned int)(((char*)(p) - (char*)(ar)->heap_list) / DSIZE))
+#define FROM_LINK(ar, v)    ((v) == 0 ? NULL : (void*)((char*)(ar)->heap_list + (size_t)(v) * DSIZE))
+
+#define PRED_FREEPT(ar, bp) FROM_LINK(ar, GETTER(bp)) // 이전 프리블록 포인터
+#define SUCC_FREEPT(ar, bp) FROM_LINK(ar, GETTER((char*)(bp) + WSIZE)) // 다음 프리블록 포인터
+#define SET_PRED_FREEPT(ar, bp, p)  PUTTER(bp, TO_LINK(ar, p))
+#define SET_SUCC_FREEPT(ar, bp, p)  PUTTER((char*)(bp) + WSIZE, TO_LINK(ar, p))
+
+/////// 스레드 캐시 (tcache)
+// 캐시 칸은 2의 거듭제곱 구간을 2^TCACHE_SUB 등분한 크기 (TCACHE_EXACT 미만은 DSIZE 간격 하나씩)
+// 캐시를 거치는 블록은 칸 크기로 올려서 할당하므로 블록 크기가 요청 크기만으로 정해짐
+//  -> mm_free_sized 는 요청 크기로 칸을 고르고, 꺼낼 때도 칸의 블록은 모두 칸 크기 이상이라 헤더를 읽지 않음
+#define TCACHE_MAX      1024    // 이 크기 미만 블록만 캐시
+#define TCACHE_SUB      2       // 2의 거듭제곱 구간 하나를 나누는 칸 수의 log2
+#define TCACHE_EXACT    (DSIZE << TCACHE_SUB)   // 이 크기 미만은 칸 폭이 DSIZE (블록 크기 하나씩)
+#define TCACHE_BINS     (TCACHE_EXACT / DSIZE + ((10 - TCACHE_SUB - 3) << TCACHE_SUB)) // 칸 수 (10 = log2(TCACHE_MAX))
+#define TCACHE_COUNT    32      // 칸당 캐시에 보관할 최대 블록 수
+#define TCACHE_BATCH    16      // 한 번에 채우거나(refill) 비우는(drain) 블록 수
+
+#define TC_NEXT(bp) (*(void**)(bp)) // 캐시 안 다음 블록 포인터 (할당 상태 블록의 페이로드 첫 칸)
+
+/////// 아레나
+// 0번 아레나는 mem_sbrk 힙을 쓰고, 1번부터는 mmap 으로 예약한 영역을 ARENA_SPAN 씩 나눠 쓴다.
+// 블록 주소가 예약 영역 안이면 (주소 - 시작) / ARENA_SPAN 으로 주인 아레나를 바로 찾음
+#define ARENA_MAX   16          // 최대 아레나 수
+#define ARENA_SPAN  (1 << 26)   // mmap 아레나 하나의 최대 크기 (64MB)
+
+/////// 작은 객체 (slab)
+// SLAB_SPAN 만큼 예약한 영역을 RUN_SIZE run 으로 잘라 쓰고, run 하나는 한 클래스의 슬롯만 담는다.
+// 슬롯에는 헤더가 없고, run 시작 주소(주소 & ~(RUN_SIZE-1))의 run_t 로 클래스와 빈 슬롯을 관리
+// 클래스마다 run 을 하나 이상 쥐고 있으므로 run 은 페이지보다 작게 (몇 클래스만 쓰는 작은 힙에서도 클래스당 1KB)
+#define SMALL_MAX       256                 // slab 으로 처리하는 최대 요청 크기
+#define SMALL_CLASSES   (SMALL_MAX / DSIZE) // 8바이트 간격 클래스 (8, 16, ..., 256)
+#define RUN_SIZE        (1 << 10)           // run 하나 크기 (256바이트 슬롯도 3개)
+#define SLAB_SPAN       (1 << 28)           // run 을 잘라 쓸 예약 영역 (256MB)
+
+#define SMALL_CLASS(size)   (((size) - 1) / DSIZE)          // 요청 크기 -> 클래스
+#define SLOT_SIZE(cls)      (((cls) + 1) * DSIZE)           // 클래스 -> 슬롯 크기
+#define RUN_OF(bp)          ((run_t*)((uintptr_t)(bp) & ~(uintptr_t)(RUN_SIZE - 1)))   // 슬롯이 속한 run
+#define RUN_HDR             ((sizeof(run_t) + 2 * DSIZE - 1) & ~(size_t)(2 * DSIZE - 1))   // run 앞부분 관리 정보 크기 (16 배수라 16 배수 클래스 슬롯은 16 정렬, mm_memalign)
+#define IS_SMALL(bp)        ((char*)(bp) >= slab_base && (char*)(bp) < slab_base + SLAB_SPAN)
+#define SLOT_NEXT(bp)       (*(void**)(bp))                 // 빈 슬롯 스택의 다음 슬롯
+
+/////// 큰 블록 (mmap)
+// 매핑 시작 + DSIZE 가 페이로드, MMAPPED 비트가 있으면 헤더가 더블 워드 (앞 워드에 매핑 크기 상위 32비트)
+// 힙 블록 헤더는 그대로 한 워드라 작은 블록 오버헤드는 같고, 4GB 넘는 블록은 항상 여기로 (임계값 상한 32MB)
+// 큰 블록을 해제하면 임계값을 그 크기까지 올려서, 같은 크기를 바로 다시 할당하면 힙에서 처리 (mmap 반복 방지)
+#define MMAP_THRESHOLD_MIN  (128 * 1024)        // 처음 임계값
+#define MMAP_THRESHOLD_MAX  (32 * 1024 * 1024)  // 임계값 상한
+#define MMAPPED             0x4                 // 헤더의 mmap 블록 비트
+#define IS_MMAPPED(p)       (GETTER(p) & MMAPPED)
+#define PAGE_BYTES          (1 << 12)           // 페이지 크기 (mmap 블록 단위, madvise 경계)
+#define PAGE_ROUND(size)    (((size) + PAGE_BYTES - 1) & ~(size_t)(PAGE_BYTES - 1))
+#define MMAP_HIGH(bp)       (*(unsigned int*)((char*)(bp) - DSIZE))   // 매핑 크기 상위 32비트 (헤더 앞 워드)
+#define MMAP_SIZE(bp)       ((size_t)(((unsigned long long)MMAP_HIGH(bp) << 32) | GET_SIZE(HDPT(bp))))   // 매핑 전체 크기
+#define MMAP_PUT(bp, len)   (MMAP_HIGH(bp) = (unsigned int)((unsigned long long)(len) >> 32), \
+                             PUTTER(HDPT(bp), PACK((unsigned int)(len), 1) | MMAPPED))
+#define HEAP_BLOCK_MAX      ((size_t)0xFFFFFFF8 - DSIZE)   // 한 워드 헤더 힙 블록에 담을 수 있는 최대 요청
+
+/////// 메모리 반환 (decay)
+// PURGE_MIN 이상 프리 블록은 리스트에 들어간 시각(ms)을 페이로드에 적어 두고,
+// DECAY_MS 동안 다시 쓰이지 않으면 헤더/리스트 포인터/시각/풋터를 뺀 안쪽 페이지를 madvise
+#ifndef DECAY_MS
+#define DECAY_MS        1000                // 반환까지 기다리는 시간 (-DDECAY_MS=... 로 조정)
+#endif
+#define PURGE_MIN       (64 * 1024)         // 반환 대상 프리 블록 최소 크기
+#define TRIM_THRESHOLD  (128 * 1024)        // 힙 끝 프리 블록이 이보다 크면 CHUNKSIZE 만 남기고 잘라냄
+#define PURGE_STAMP(bp) (*(unsigned int*)((char*)(bp) + 2 * DSIZE))   // 리스트 포인터 뒤, 0 이면 이미 반환됨
+#ifdef MADV_FREE
+#define PURGE_ADVICE    MADV_FREE           // 메모리가 부족할 때 커널이 가져감
+#else
+#define PURGE_ADVICE    MADV_DONTNEED
+#endif
+
+/////// 주소순 리스트 (-DADDRESS_ORDERED)
+// 아레나를 REGION_SIZE 칸으로 나눠 (칸, 클래스) 마다 주소가 가장 작은 프리 블록을 기억해 두고,
+// 넣을 때는 같은 칸(없으면 앞쪽으로 가장 가까운 칸)의 그 클래스 첫 블록부터 걸어서 자리를 찾음
+#define REGION_SHIFT    16                      // 칸 크기 64KB (칸마다 LISTLIMIT 개 포인터)
+#define REGION_MIN      64                      // 인덱스 배열 처음 칸 수 (모자라면 두 배씩 mremap)
+#define REGION_OF(ar, bp)   ((size_t)((char*)(bp) - (ar)->region_base) >> REGION_SHIFT)   // 블록이 속한 칸
+#define REGION_FIRST(ar, r, i)  ((ar)->region_first[(r) * LISTLIMIT + (i)])   // r 칸 i 클래스 첫 블록
+// 앞쪽으로 가장 가까운 칸은 클래스마다 두 단계 비트맵에서 clz 로 (칸 하나씩 거꾸로 걷지 않음)
+#define REGION_BITS(ar, w, i)   ((ar)->region_bits[(w) * LISTLIMIT + (i)])  // i 클래스 칸 64개 (w 워드) 중 첫 블록이 있는 칸 비트
+#define REGION_SUM(ar, v, i)    ((ar)->region_sum[(v) * LISTLIMIT + (i)])   // i 클래스 REGION_BITS 워드 64개 (v 요약 워드) 중 0 이 아닌 워드 비트
+#define BIT(n)                  (1ull << ((n) & 63))    // 64비트 워드 안 n 번 비트
+
+struct small_bin;
 
-static void* heap_list = NULL; // 힙 리스트 시작 포인터
-static void* segregation_list[LISTLIMIT];
+typedef struct run {
+    struct run* next;   // 같은 클래스의 빈 슬롯 있는 run 리스트
+    struct run* prev;
+    struct small_bin* bin;   // 이 run 을 가진 클래스 (아레나별)
+    void* free_slot;    // 해제된 슬롯 스택
+    unsigned short cls;      // 크기 클래스
+    unsigned short nfree;    // 남은 슬롯 수
+    unsigned short nslots;   // 전체 슬롯 수
+    unsigned short bump;     // 아직 한 번도 안 쓴 첫 슬롯 번호
+} run_t;
 
-static int mm_init(void);
-static void* extend_heap(size_t words);
-static void* coalesce(void* bp);
+typedef struct small_bin {
+    pthread_mutex_t lock;   // 클래스 락 (아레나 힙 락과 따로)
+    run_t* partial;   // 빈 슬롯이 남은 run 리스트
+} small_bin_t;
+
+typedef struct {
+    void* bin[TCACHE_BINS];  // 칸별 캐시 스택 (LIFO)
+    int count[TCACHE_BINS];  // 칸별 캐시 블록 수
+} tcache_t;
+
+typedef struct {
+    pthread_mutex_t lock;   // 아레나 락
+    void* heap_list;   // 힙 리스트 시작 포인터 (NULL 이면 아직 초기화 전)
+    void* segregation_list[LISTLIMIT];
+    unsigned int list_bitmap; // 비어있지 않은 리스트 비트맵
+#ifdef NEXT_FIT
+    void* rover[LISTLIMIT]; // 클래스별 next fit 탐색 시작 블록 (NULL 이면 리스트 처음부터)
+#endif
+#ifdef ADDRESS_ORDERED
+    char* region_base;  // 칸 번호의 기준 (아레나 시작)
+    void** region_first; // (칸, 클래스) 별 주소가 가장 작은 프리 블록 (mmap, mm_init 이 다시 불려도 재사용)
+    size_t region_cap;  // 인덱스 배열 칸 수
+    unsigned long long* region_bits; // REGION_BITS (칸 64개마다 클래스 수만큼 워드)
+    unsigned long long* region_sum; // REGION_SUM (칸 4096개마다 클래스 수만큼 워드)
+#endif
+    unsigned int now;   // 마지막으로 읽은 시각 (ms), 큰 프리 블록 시각 기록용
+    unsigned int last_decay; // 마지막으로 오래된 블록을 반환한 시각 (ms)
+    char* brk;   // mmap 아레나의 현재 끝
+    char* limit; // mmap 아레나의 예약 끝
+    small_bin_t small[SMALL_CLASSES]; // 아레나별 slab 클래스
+} arena_t;
+
+static arena_t arenas[ARENA_MAX];
+static int narenas = 1; // 사용하는 아레나 수 (코어 수, 최대 ARENA_MAX)
+static int next_arena = 0; // 다음 스레드에 배정할 아레나 (라운드 로빈)
+static char* arena_base = NULL; // 1번 아레나부터의 예약 영역 시작
+static pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+static __thread arena_t* my_arena; // 현재 스레드에 배정된 아레나
+
+static char* slab_base = NULL; // slab 예약 영역 시작
+static char* slab_brk = NULL; // 아직 run 으로 안 잘린 곳
+static run_t* free_runs = NULL; // 다 비어서 돌려받은 run 스택
+static pthread_mutex_t slab_lock = PTHREAD_MUTEX_INITIALIZER; // slab_brk, free_runs 보호
+
+static size_t mmap_threshold = MMAP_THRESHOLD_MIN; // 이 크기 이상 요청은 mmap (스레드 공유, atomic 으로 읽고 씀)
+static size_t mmap_bytes = 0; // 지금 mmap 블록들의 매핑 크기 합 (atomic 으로 더하고 뺌)
+
+static pthread_key_t tcache_key; // 스레드 종료 시 캐시를 비우기 위한 키
+static pthread_once_t tcache_once = PTHREAD_ONCE_INIT;
+static __thread tcache_t tcache; // 스레드별 캐시
+static __thread int tcache_attached; // 종료 콜백 등록 여부
+
+int mm_init(void);
+static void* extend_heap(arena_t* ar, size_t words);
+static void* coalesce(arena_t* ar, void* bp);
 void* mm_malloc(size_t size);
-static void* first_fit(size_t a_size);
-static void place(void* bp, size_t a_size);
+static void* first_fit(arena_t* ar, size_t a_size);
+static void place(arena_t* ar, void* bp, size_t a_size);
 void mm_free(void* bp);
+void mm_free_sized(void* bp, size_t size);
 void* mm_realloc(void* bp, size_t size);
+size_t mm_usable_size(void* bp);
+size_t mm_footprint(void);
+void mm_atfork_prepare(void);
+void mm_atfork_parent(void);
+void mm_atfork_child(void);
+void* mm_memalign(size_t alignment, size_t size);
+void* mm_aligned_alloc(size_t alignment, size_t size);
 
+static void* heap_malloc(arena_t* ar, size_t a_size);
+static void heap_free(arena_t* ar, void* bp);
+static void* heap_memalign(arena_t* ar, size_t alignment, size_t a_size);
+static void* aligned_fit(arena_t* ar, size_t alignment, size_t a_size);
+static char* aligned_payload(void* bp, size_t alignment);
+static void* place_aligned(arena_t* ar, void* bp, size_t alignment, size_t a_size);
+static int heap_realloc(void* bp, size_t size);
+static void heap_trim(arena_t* ar, void* bp);
+static void heap_decay(arena_t* ar, unsigned int now);
+static void purge_block(void* bp);
+static unsigned int now_ms(void);
+#ifdef CHECK_SIZED
+static void sized_check(void* bp, size_t size);
+#endif
 
-static void remove_block(void* bp);
-static void insert_block(void* bp, size_t size);
+static void arena_lock_init(void);
+static int arena_init(arena_t* ar);
+static void* arena_sbrk(arena_t* ar, size_t size);
+static arena_t* arena_of(void* bp);
+static arena_t* thread_arena(void);
+
+static void* small_malloc(size_t size);
+static void small_free(void* bp);
+static run_t* run_new(small_bin_t* bin, int cls);
+static void run_release(run_t* r);
+
+static void* mmap_malloc(size_t size);
+static void mmap_free(void* bp);
+static void* mmap_realloc(void* bp, size_t size);
+
+static int list_index(size_t size);
+static void remove_block(arena_t* ar, void* bp);
+static void insert_block(arena_t* ar, void* bp, size_t size);
+#ifdef ADDRESS_ORDERED
+static int region_reserve(arena_t* ar, char* end);
+static void* region_pred(arena_t* ar, int i, void* bp);
+static void region_mark(arena_t* ar, size_t r, int i);
+static long region_before(arena_t* ar, size_t r, int i);
+#endif
+
+static void tcache_attach(void);
+static size_t tc_round(size_t a_size);
+static int tc_bin(size_t size);
+static void* tcache_get(int i);
+static void tcache_refill(int i, size_t a_size);
+static void tcache_drain(tcache_t* tc, int i, int n);
+static void tcache_flush(void* arg);
 
 
 // mm_init
 int mm_init(void)
 {
-    // 메모리 확장 실패
-    if ((heap_list = mem_sbrk(6 * WSIZE)) == (void*)-1) {
-        return -1;
-    }
+    long ncpu;
 
-    PUTTER(heap_list, 0);                             // 시작 부분
-    PUTTER(heap_list + (1 * WSIZE), PACK(2 * DSIZE, 1)); // 맨 앞 헤더 할당된 것
-    PUTTER(heap_list + (2 * WSIZE), NULL);            // 이전 포인터 null
-    PUTTER(heap_list + (3 * WSIZE), NULL);            // 이후 포인터 null
-    PUTTER(heap_list + (4 * WSIZE), PACK(2 * DSIZE, 1));  // 풋터 
-    PUTTER(heap_list + (5 * WSIZE), PACK(0, 1));      // 뒷부분 헤더
+    pthread_once(&arena_once, arena_lock_init);
 
-    free_list = heap_list + (2 * WSIZE); // 프리 블록 리스트의 시작을 맨 앞 다음 첫 프리블록으로
+    // 이전 힙의 블록이 남아 있으면 안 되므로 호출한 스레드의 캐시 비우기
+    memset(&tcache, 0, sizeof(tcache));
 
-    if (extend_heap(CHUNKSIZE / WSIZE) == NULL) // 확장 ~
-        return -1;
+    // 아레나 수는 코어 수만큼
+    ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    narenas = (ncpu < 1) ? 1 : (ncpu > ARENA_MAX) ? ARENA_MAX : (int)ncpu;
+    next_arena = 0;
+    my_arena = NULL;
+
+    // 1번 아레나부터 쓸 주소 공간 예약 (처음 한 번만, 이후엔 이전 내용만 버림)
+    if (arena_base == NULL) {
+        arena_base = mmap(NULL, (size_t)(ARENA_MAX - 1) * ARENA_SPAN, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (arena_base == MAP_FAILED) {
+            arena_base = NULL;
+            return -1;
+        }
+    }
+    else {
+        madvise(arena_base, (size_t)(ARENA_MAX - 1) * ARENA_SPAN, MADV_DONTNEED);
+    }
 
+    // slab run 을 잘라 쓸 주소 공간 예약 (RUN_SIZE 정렬이 되도록 한 run 만큼 더 잡음)
+    if (slab_base == NULL) {
+        char* p = mmap(NULL, SLAB_SPAN + RUN_SIZE, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p == MAP_FAILED) {
+            return -1;
+        }
+        slab_base = (char*)(((uintptr_t)p + RUN_SIZE - 1) & ~(uintptr_t)(RUN_SIZE - 1));
+    }
+    else {
+        madvise(slab_base, SLAB_SPAN, MADV_DONTNEED);
+    }
+    slab_brk = slab_base;
+    free_runs = NULL;
+    __atomic_store_n(&mmap_threshold, MMAP_THRESHOLD_MIN, __ATOMIC_RELAXED);
+    __atomic_store_n(&mmap_bytes, 0, __ATOMIC_RELAXED);
+
+    for (int k = 0; k < ARENA_MAX; k++) {
+        arenas[k].heap_list = NULL;
+        arenas[k].brk = (k == 0) ? NULL : arena_base + (size_t)(k - 1) * ARENA_SPAN;
+        arenas[k].limit = (k == 0) ? NULL : arenas[k].brk + ARENA_SPAN;
+        for (int c = 0; c < SMALL_CLASSES; c++) {
+            arenas[k].small[c].partial = NULL;
+        }
+    }
+
+    // 0번 아레나(mem_sbrk 힙)도 다른 아레나처럼 처음 힙 블록을 할당할 때 초기화 (작은 요청만 오면 청크를 안 잡음)
     return 0;
 }
 
-// mm_malloc 
+// mm_malloc
 void* mm_malloc(size_t size) {
     size_t a_size; // 실제로 할당할 블록 크기
-    size_t extend_size; // 힙을 확장할 크기
     char* bp; // 찾은 프리 블록의 시작 주소
+    int i; // 캐시 칸
+    arena_t* ar; // 할당할 아레나
 
     if (size == 0) { // 요청하는 크기가 0이면 할당 불필요
         return NULL;
     }
 
+    // 작은 요청은 slab 슬롯으로 (slab 영역이 가득 찼으면 일반 힙으로)
+    if (size <= SMALL_MAX && (bp = small_malloc(size)) != NULL) {
+        return bp;
+    }
+
+    // 큰 요청은 전용 매핑으로
+    if (size >= __atomic_load_n(&mmap_threshold, __ATOMIC_RELAXED)) {
+        return mmap_malloc(size);
+    }
+
     // 할당할 프리블록 찾기
-    if (size <= DSIZE) { // 최소 블록 크기 이하로 요청 받은 경우 최소 크기 블록으로 할당
+    if (size <= DSIZE + WSIZE) { // 최소 블록 크기 이하로 요청 받은 경우 최소 크기 블록으로 할당
         a_size = 2 * DSIZE;
     }
     else { // 요청보다 더 크게 할당
-        // 헤더와 풋터를 위한 size + DSIZE
-        a_size = ((size + DSIZE - 1 + DSIZE) / DSIZE) * DSIZE;
+        // 할당 블록은 헤더만 있으므로 size + WSIZE
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
     }
+    a_size = tc_round(a_size); // 캐시를 거치는 크기면 칸 크기로
 
-    // 적절한 프리 블록 탐색
-    if ((bp = worst_fit(a_size)) != NULL) {
-        place(bp, a_size);
-        return bp;  // 프리 블록 적절한 것 발견했다면 return 후 종료
+    // 작은 블록은 스레드 캐시에서 먼저 찾기 (락 없음)
+    if (a_size < TCACHE_MAX) {
+        i = tc_bin(a_size);
+        if ((bp = tcache_get(i)) != NULL) {
+            return bp;
+        }
+        tcache_refill(i, a_size); // 캐시가 비었으면 공유 힙에서 한꺼번에 채우기
+        if ((bp = tcache_get(i)) != NULL) {
+            return bp;
+        }
     }
-    // 적절한 프리블록을 못 찾았다면
-    extend_size = MAX(a_size, CHUNKSIZE);  // 요청 크기와 기본 크기 중 큰 값으로 확장
-    if ((bp = extend_heap(extend_size / WSIZE)) == NULL) { // 정해진 크기로 힙 확장 
-        return NULL; // 실패하면 -1 NULL
+
+    // 배정된 아레나에서 할당, 아레나가 가득 찼으면 다른 아레나에서
+    ar = thread_arena();
+    for (int k = 0; k < narenas; k++) {
+        pthread_mutex_lock(&ar->lock);
+        bp = heap_malloc(ar, a_size);
+        pthread_mutex_unlock(&ar->lock);
+        if (bp != NULL) {
+            return bp;
+        }
+        ar = &arenas[(ar - arenas + 1) % narenas];
     }
-    place(bp, a_size);  // bp 에는 함수를 통해 프리 블록 할당
-    return bp;  // 성공하면 블록 시작 주소 리턴
+    return NULL;
 }
 
 // mm_free
 void mm_free(void* bp)
 {
-    size_t size = GET_SIZE(HDPT(bp)); // 블록 해제를 위해 매개변수 받기
+    size_t size; // 블록 크기
+    int i; // 캐시 칸
+    arena_t* ar; // 블록의 주인 아레나
 
-    PUTTER(HDPT(bp), PACK(size, 0)); // 프리블록으로 상태 변경
-    PUTTER(FTPT(bp), PACK(size, 0));
-    coalesce(bp); // 프리 블록 병합
+    if (bp == NULL) {
+        return;
+    }
+
+    if (IS_SMALL(bp)) { // slab 슬롯은 헤더가 없으므로 run 으로 반환
+        small_free(bp);
+        return;
+    }
+
+    if (IS_MMAPPED(HDPT(bp))) { // 큰 블록은 매핑째 반환
+        mmap_free(bp);
+        return;
+    }
+
+    size = GET_SIZE(HDPT(bp)); // 블록 해제를 위해 매개변수 받기
+
+    // 작은 블록은 할당 상태 그대로 블록 크기 이하 가장 큰 칸에 넣고 병합은 미룸
+    if (size < TCACHE_MAX) {
+        i = tc_bin(size);
+        tcache_attach();
+        TC_NEXT(bp) = tcache.bin[i];
+        tcache.bin[i] = bp;
+        if (++tcache.count[i] > TCACHE_COUNT) { // 캐시가 넘치면 한 묶음 돌려주기
+            tcache_drain(&tcache, i, TCACHE_BATCH);
+        }
+        return;
+    }
+
+    ar = arena_of(bp); // 블록 주소로 주인 아레나 찾기
+    pthread_mutex_lock(&ar->lock);
+    heap_free(ar, bp);
+    pthread_mutex_unlock(&ar->lock);
+}
+
+// mm_free_sized : size 는 이 블록을 할당(재할당)할 때 요청한 크기
+// mmap 블록은 요청이 MMAP_THRESHOLD_MIN 이상일 때만 생기므로 그보다 작으면 힙 블록이고,
+// 캐시 칸은 요청 크기로 바로 계산 (mm_malloc 과 같이 칸 크기로 올리므로 실제 블록은 그 칸 크기 이상)
+// 헤더는 여기서도, 캐시에서 다시 꺼낼 때도 읽지 않음 (캐시가 넘쳐 아레나로 돌려줄 때 병합하면서 읽음)
+void mm_free_sized(void* bp, size_t size)
+{
+    size_t a_size; // 요청 크기로 계산한 블록 크기
+    int i; // 캐시 칸
+
+    if (bp == NULL) {
+        return;
+    }
+#ifdef CHECK_SIZED
+    sized_check(bp, size);
+#endif
+
+    if (IS_SMALL(bp)) { // slab 슬롯은 주소 범위만으로 구분
+        small_free(bp);
+        return;
+    }
+    if (size == 0 || size >= MMAP_THRESHOLD_MIN) { // mmap 블록일 수 있으면 헤더를 보는 mm_free 로
+        mm_free(bp);
+        return;
+    }
+
+    if (size <= DSIZE + WSIZE) { // mm_malloc 과 같은 방식으로 블록 크기 계산
+        a_size = 2 * DSIZE;
+    }
+    else {
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
+    }
+    a_size = tc_round(a_size);
+
+    if (a_size >= TCACHE_MAX) { // 아레나로 돌려줄 블록은 병합하면서 어차피 헤더를 읽음
+        mm_free(bp);
+        return;
+    }
+    i = tc_bin(a_size);
+    tcache_attach();
+    TC_NEXT(bp) = tcache.bin[i];
+    tcache.bin[i] = bp;
+    if (++tcache.count[i] > TCACHE_COUNT) { // 캐시가 넘치면 한 묶음 돌려주기
+        tcache_drain(&tcache, i, TCACHE_BATCH);
+    }
 }
 
-// mm_realloc
+// mm_realloc : 힙 블록은 뒤 블록이 프리거나 아레나 끝이면 제자리에서 늘리고, 줄일 때는 뒷부분을 돌려줌
 void* mm_realloc(void* bp, size_t size)
 {
     void* old_bp = bp; // 기존 블록 포인터
     void* new_bp;  // 새로 할당되는 블록 할당 포인터
     size_t copySize; // 복사 데이터 크기
 
+    // 같은 slab 클래스 안에서 바뀌면 슬롯 그대로 사용
+    if (IS_SMALL(old_bp) && size > 0 && size <= SMALL_MAX && SMALL_CLASS(size) == RUN_OF(old_bp)->cls) {
+        return old_bp;
+    }
+
+    if (!IS_SMALL(old_bp) && IS_MMAPPED(HDPT(old_bp))) { // 큰 블록은 mremap 으로 복사 없이
+        if (size >= MMAP_THRESHOLD_MIN) {
+            return mmap_realloc(old_bp, size);
+        }
+        // 임계값 최소보다 작아지면 힙으로 옮김 (mm_free_sized 가 작은 크기는 mmap 블록이 아니라고 믿음)
+    }
+    else if (!IS_SMALL(old_bp) && heap_realloc(old_bp, size)) { // 힙 블록은 제자리에서 먼저 시도
+        return old_bp;
+    }
+
     new_bp = mm_malloc(size); // 새 블록 할당
 
     if (new_bp == NULL) return NULL;
 
-    copySize = GET_SIZE(HDPT(old_bp)); // 기존 블록 크기
+    copySize = mm_usable_size(old_bp); // 기존 블록 페이로드 크기 (slab 슬롯 / mmap 블록 / 힙 블록)
 
     if (size < copySize) // 재할당할 크기가 기존보다 작으면
         copySize = size; // 원래 size만큼조정
@@ -150,151 +524,1057 @@ void* mm_realloc(void* bp, size_t size)
     return new_bp; // 실패시 블록 할당 역할
 }
 
+// mm_usable_size : 블록에 실제로 쓸 수 있는 바이트 (slab 슬롯 / mmap 블록 / 힙 블록)
+size_t mm_usable_size(void* bp)
+{
+    if (bp == NULL) {
+        return 0;
+    }
+    if (IS_SMALL(bp)) { // 슬롯 크기가 곧 데이터 크기
+        return SLOT_SIZE(RUN_OF(bp)->cls);
+    }
+    if (IS_MMAPPED(HDPT(bp))) { // 매핑 앞 더블 워드가 헤더
+        return MMAP_SIZE(bp) - DSIZE;
+    }
+    return GET_SIZE(HDPT(bp)) - WSIZE; // 할당 블록은 풋터 없음
+}
+
+// mm_footprint : 지금 쓰는 주소 공간 (0번 아레나 힙 + mmap 아레나 + 잘라 쓴 slab run + mmap 블록)
+// 다른 스레드가 할당 중이면 근사값 (락 없이 읽음)
+size_t mm_footprint(void)
+{
+    size_t total = mem_heapsize() + (size_t)(slab_brk - slab_base) + __atomic_load_n(&mmap_bytes, __ATOMIC_RELAXED);
+
+    for (int k = 1; k < ARENA_MAX; k++) { // 예약 영역 시작부터 지금 끝까지
+        total += (size_t)(arenas[k].brk - (arena_base + (size_t)(k - 1) * ARENA_SPAN));
+    }
+    return total;
+}
+
+// mm_memalign : alignment (2의 거듭제곱) 배수 주소의 페이로드
+// 정렬된 페이로드가 들어가는 프리 블록을 찾아 앞 조각은 프리 블록으로 떼어 내고, 뒷부분은 place 가 분할
+void* mm_memalign(size_t alignment, size_t size)
+{
+    size_t a_size; // 실제로 할당할 블록 크기
+    char* bp; // 정렬된 페이로드
+    int i; // 캐시 칸
+    arena_t* ar; // 할당할 아레나
+
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) { // 2의 거듭제곱만
+        errno = EINVAL;
+        return NULL;
+    }
+    if (alignment <= DSIZE) { // 기본 정렬로 충분
+        return mm_malloc(size);
+    }
+    if (size == 0) {
+        return NULL;
+    }
+    if (alignment == 2 * DSIZE && size <= SMALL_MAX) { // 16 정렬은 16 배수 클래스 slab 슬롯으로 (C++ new 가 모두 이쪽, preload)
+        if ((bp = small_malloc((size + 2 * DSIZE - 1) & ~(size_t)(2 * DSIZE - 1))) != NULL) {
+            return bp;
+        }
+    }
+    if (size > HEAP_BLOCK_MAX) { // 그 밖의 정렬 블록은 힙에서만 주므로 한 워드 헤더 한도까지
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    if (size <= DSIZE + WSIZE) { // mm_malloc 과 같은 방식으로 블록 크기 계산
+        a_size = 2 * DSIZE;
+    }
+    else {
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
+    }
+    a_size = tc_round(a_size); // mm_free_sized 가 요청 크기로 칸을 고를 수 있게 mm_malloc 과 같은 크기로
+
+    // 16 정렬은 캐시 맨 위 블록이 16 정렬이면 그대로 (C++ delete 로 돌아온 블록은 대부분 16 정렬)
+    if (alignment == 2 * DSIZE && a_size < TCACHE_MAX) {
+        i = tc_bin(a_size);
+        if (tcache.bin[i] != NULL && ((uintptr_t)tcache.bin[i] & (2 * DSIZE - 1)) == 0) {
+            return tcache_get(i);
+        }
+    }
+
+    // 배정된 아레나에서, 가득 찼으면 다른 아레나에서 (mmap 블록은 정렬을 보장하지 않으므로 힙에서만)
+    ar = thread_arena();
+    for (int k = 0; k < narenas; k++) {
+        pthread_mutex_lock(&ar->lock);
+        bp = heap_memalign(ar, alignment, a_size);
+        pthread_mutex_unlock(&ar->lock);
+        if (bp != NULL) {
+            return bp;
+        }
+        ar = &arenas[(ar - arenas + 1) % narenas];
+    }
+    return NULL;
+}
+
+// mm_aligned_alloc : C11 aligned_alloc 과 같은 모양
+void* mm_aligned_alloc(size_t alignment, size_t size)
+{
+    return mm_memalign(alignment, size);
+}
+
+// heap_malloc : 아레나에서 a_size 블록 할당 (아레나 락 잡은 상태에서 호출)
+static void* heap_malloc(arena_t* ar, size_t a_size) {
+    size_t extend_size; // 힙을 확장할 크기
+    char* bp; // 찾은 프리 블록의 시작 주소
+
+    if (ar->heap_list == NULL && arena_init(ar) < 0) { // 처음 쓰는 아레나면 초기화
+        return NULL;
+    }
+
+    // 적절한 프리 블록 탐색
+    if ((bp = first_fit(ar, a_size)) != NULL) {
+        place(ar, bp, a_size);
+        return bp;  // 프리 블록 적절한 것 발견했다면 return 후 종료
+    }
+    // 적절한 프리블록을 못 찾았다면
+    extend_size = MAX(a_size, CHUNKSIZE);  // 요청 크기와 기본 크기 중 큰 값으로 확장
+    if ((bp = extend_heap(ar, extend_size / WSIZE)) == NULL) { // 정해진 크기로 힙 확장
+        return NULL; // 실패하면 -1 NULL
+    }
+    place(ar, bp, a_size);  // bp 에는 함수를 통해 프리 블록 할당
+    return bp;  // 성공하면 블록 시작 주소 리턴
+}
+
+// heap_memalign : 아레나에서 정렬된 페이로드 할당 (아레나 락 잡은 상태에서 호출)
+static void* heap_memalign(arena_t* ar, size_t alignment, size_t a_size) {
+    size_t extend_size; // 힙을 확장할 크기
+    char* bp; // 정렬된 페이로드를 담을 프리 블록
+
+    if (ar->heap_list == NULL && arena_init(ar) < 0) { // 처음 쓰는 아레나면 초기화
+        return NULL;
+    }
+    if ((bp = aligned_fit(ar, alignment, a_size)) == NULL) { // 어느 주소에서 시작해도 들어가는 크기로 힙 확장
+        extend_size = MAX(a_size + alignment + 2 * DSIZE, CHUNKSIZE);
+        if ((bp = extend_heap(ar, extend_size / WSIZE)) == NULL) {
+            return NULL;
+        }
+    }
+    return place_aligned(ar, bp, alignment, a_size);
+}
+
+// aligned_fit : 정렬된 페이로드 + a_size 가 들어가는 프리 블록 (요청 리스트부터 위 리스트들까지 처음 맞는 블록)
+static void* aligned_fit(arena_t* ar, size_t alignment, size_t a_size) {
+    void* bp; // 블록 포인터
+    unsigned int map; // 요청 리스트 이상 비어있지 않은 리스트들
+
+    for (map = ar->list_bitmap & ~(CLASS_BIT(list_index(a_size)) - 1); map != 0; map &= map - 1) {
+        for (bp = ar->segregation_list[__builtin_ctz(map)]; bp != NULL; bp = SUCC_FREEPT(ar, bp)) {
+            if (aligned_payload(bp, alignment) + a_size <= (char*)bp + GET_SIZE(HDPT(bp))) {
+                return bp;
+            }
+        }
+    }
+    return NULL;
+}
+
+// aligned_payload : 프리 블록 bp 안에서 처음으로 정렬되는 페이로드 주소 (앞 조각은 없거나 최소 블록 이상)
+static char* aligned_payload(void* bp, size_t alignment) {
+    char* p = (char*)(((uintptr_t)bp + alignment - 1) & ~(uintptr_t)(alignment - 1));
+
+    if (p != (char*)bp && p - (char*)bp < 2 * DSIZE) { // 앞 조각이 최소 블록보다 작으면 다음 정렬 주소
+        p += alignment;
+    }
+    return p;
+}
+
+// place_aligned : 정렬된 자리 앞 조각을 프리 블록으로 떼어 내고 정렬된 자리에서 place
+static void* place_aligned(arena_t* ar, void* bp, size_t alignment, size_t a_size) {
+    char* p = aligned_payload(bp, alignment); // 정렬된 페이로드
+    size_t c_size = GET_SIZE(HDPT(bp)); // 현재 블록 크기
+    size_t lead = p - (char*)bp; // 앞 조각 크기
+
+    if (lead > 0) {
+        remove_block(ar, bp);
+        // 앞 조각 : 프리 블록의 앞 블록은 항상 할당 상태이므로 병합할 것 없음
+        PUTTER(HDPT(bp), PACK(lead, 0) | IS_PREV_ALLOCATED(HDPT(bp)));
+        PUTTER(FTPT(bp), PACK(lead, 0));
+        insert_block(ar, bp, lead);
+        // 정렬된 자리부터 나머지 (앞 블록은 프리)
+        PUTTER(HDPT(p), PACK(c_size - lead, 0));
+        PUTTER(FTPT(p), PACK(c_size - lead, 0));
+        insert_block(ar, p, c_size - lead);
+    }
+    place(ar, p, a_size); // 뒷부분은 최소 블록 이상이면 분할
+    return p;
+}
+
+// heap_free : 주인 아레나에 블록 반환 (아레나 락 잡은 상태에서 호출)
+static void heap_free(arena_t* ar, void* bp) {
+    size_t size = GET_SIZE(HDPT(bp));
+
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp))); // 프리블록으로 상태 변경
+    PUTTER(FTPT(bp), PACK(size, 0));
+    CLR_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 다음 블록에 이전 블록 프리 표시
+    bp = coalesce(ar, bp); // 프리 블록 병합 후 리스트에 추가
+
+    // 큰 프리 블록이 생겼을 때만 시계를 읽음 (작은 free 는 그대로 빠르게)
+    if (GET_SIZE(HDPT(bp)) >= PURGE_MIN) {
+        ar->now = now_ms();
+        PURGE_STAMP(bp) = ar->now;
+        // mmap 아레나 끝 블록은 잘라냄 (0번 아레나는 줄일 수 없으므로 다른 큰 블록처럼 DECAY_MS 뒤 heap_decay 가 반환)
+        if (ar != &arenas[0] && GET_SIZE(HDPT(NEXT_BLKP(bp))) == 0 && GET_SIZE(HDPT(bp)) >= TRIM_THRESHOLD) {
+            heap_trim(ar, bp);
+        }
+        if (ar->now - ar->last_decay >= DECAY_MS) {
+            heap_decay(ar, ar->now);
+        }
+    }
+}
+
+// heap_trim : mmap 아레나 끝 프리 블록을 CHUNKSIZE 만 남기고 아레나를 줄임
+static void heap_trim(arena_t* ar, void* bp) {
+    char* old_end = (char*)bp + GET_SIZE(HDPT(bp)); // 지금 아레나 끝 (에필로그 헤더 바로 뒤)
+    char* start;
+    char* end;
+
+    remove_block(ar, bp);
+    PUTTER(HDPT(bp), PACK(CHUNKSIZE, 0) | PREV_ALLOC); // 남길 프리 블록
+    PUTTER(FTPT(bp), PACK(CHUNKSIZE, 0));
+    PUTTER(HDPT(NEXT_BLKP(bp)), PACK(0, 1)); // 새 에필로그 헤더
+    insert_block(ar, bp, CHUNKSIZE);
+    ar->brk = NEXT_BLKP(bp);
+
+    start = (char*)PAGE_ROUND((uintptr_t)ar->brk);
+    end = (char*)((uintptr_t)old_end & ~(uintptr_t)(PAGE_BYTES - 1));
+    if (end > start) {
+        madvise(start, end - start, MADV_DONTNEED); // 잘라낸 부분은 다시 늘릴 때 0 페이지로
+    }
+}
+
+// heap_decay : DECAY_MS 넘게 리스트에 있던 큰 프리 블록들의 안쪽 페이지 반환
+static void heap_decay(arena_t* ar, unsigned int now) {
+    void* bp;
+
+    ar->last_decay = now;
+    for (int i = list_index(PURGE_MIN); i < LISTLIMIT; i++) {
+        for (bp = ar->segregation_list[i]; bp != NULL; bp = SUCC_FREEPT(ar, bp)) {
+            if (GET_SIZE(HDPT(bp)) >= PURGE_MIN && PURGE_STAMP(bp) != 0 && now - PURGE_STAMP(bp) >= DECAY_MS) {
+                purge_block(bp);
+            }
+        }
+    }
+}
+
+// purge_block : 프리 블록의 페이지 경계 안쪽 (관리 정보를 뺀 부분) 반환
+static void purge_block(void* bp) {
+    char* start = (char*)PAGE_ROUND((uintptr_t)bp + 3 * DSIZE);
+    char* end = (char*)((uintptr_t)FTPT(bp) & ~(uintptr_t)(PAGE_BYTES - 1));
+
+    if (end > start) {
+        madvise(start, end - start, PURGE_ADVICE);
+    }
+    PURGE_STAMP(bp) = 0; // 반환 완료
+}
+
+#ifdef CHECK_SIZED
+// sized_check : mm_free_sized 에 온 크기가 블록과 맞는지 (slab 은 같은 클래스나 mm_memalign 이 16 배수로 올린 클래스, mmap 은 같은 매핑 크기)
+// 힙 블록은 캐시가 같은 클래스의 더 큰 블록을 내주므로, 요청 크기 블록 이상이고 클래스가 하나 위까지면 통과
+static void sized_check(void* bp, size_t size) {
+    size_t a_size; // 요청 크기로 계산한 블록 크기
+    size_t b_size; // 헤더의 블록 크기
+
+    if (size == 0) {
+        return;
+    }
+    if (IS_SMALL(bp)) {
+        if (size <= SMALL_MAX && (SMALL_CLASS(size) == RUN_OF(bp)->cls || SMALL_CLASS((size + 2 * DSIZE - 1) & ~(size_t)(2 * DSIZE - 1)) == RUN_OF(bp)->cls)) {
+            return;
+        }
+        b_size = SLOT_SIZE(RUN_OF(bp)->cls);
+    }
+    else if (IS_MMAPPED(HDPT(bp))) {
+        b_size = MMAP_SIZE(bp);
+        if (size >= MMAP_THRESHOLD_MIN && PAGE_ROUND(size + DSIZE) == b_size) {
+            return;
+        }
+    }
+    else {
+        a_size = tc_round((size <= DSIZE + WSIZE) ? 2 * DSIZE : ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE);
+        b_size = GET_SIZE(HDPT(bp));
+        if (b_size >= a_size && list_index(b_size) <= list_index(a_size) + 1) {
+            return;
+        }
+    }
+    fprintf(stderr, "mm_free_sized: %p freed with size %zu, block size %zu\n", bp, size, b_size);
+    abort();
+}
+#endif
+
+// now_ms : 단조 시계 (ms, 0 은 반환 완료 표시라 홀수로)
+static unsigned int now_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned int)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000) | 1;
+}
+
+// heap_realloc : bp 블록을 제자리에서 size 에 맞게 늘리거나 줄임, 안 되면 0
+static int heap_realloc(void* bp, size_t size) {
+    arena_t* ar = arena_of(bp); // 블록의 주인 아레나
+    size_t a_size; // 새로 필요한 블록 크기
+    size_t c_size; // 기존 블록 크기
+    size_t n_size; // 제자리에서 쓸 수 있는 크기
+    void* next_bp; // 다음 블록
 
-static void* extend_heap(size_t words) {
+    if (size > HEAP_BLOCK_MAX) { // 한 워드 헤더에 담을 수 없으면 mmap 블록으로 옮기게
+        return 0;
+    }
+    if (size <= DSIZE + WSIZE) { // mm_malloc 과 같은 방식으로 블록 크기 계산
+        a_size = 2 * DSIZE;
+    }
+    else {
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
+    }
+    a_size = tc_round(a_size); // 제자리에서 바꾼 블록도 mm_malloc 과 같은 크기 이상으로
+
+    pthread_mutex_lock(&ar->lock);
+    c_size = n_size = GET_SIZE(HDPT(bp));
+    next_bp = NEXT_BLKP(bp);
+
+    // 다음 블록이 프리면 합쳐서 쓸 수 있음 (캐시에 있는 블록은 할당 상태라 건드리지 않음)
+    if (!IS_ALLOCATED(HDPT(next_bp))) {
+        n_size += GET_SIZE(HDPT(next_bp));
+    }
+    // 그래도 모자라는데 아레나의 마지막 블록이면 모자란 만큼만 확장
+    if (n_size < a_size && GET_SIZE(HDPT((char*)bp + n_size)) == 0
+        && (long)arena_sbrk(ar, a_size - n_size) != -1) {
+        n_size = a_size;
+        PUTTER(HDPT((char*)bp + n_size), PACK(0, 1)); // 새 에필로그 헤더
+    }
+
+    if (n_size < a_size) {
+        pthread_mutex_unlock(&ar->lock);
+        return 0;
+    }
+
+    if (n_size != c_size && !IS_ALLOCATED(HDPT(next_bp))) { // 합칠 다음 블록은 리스트에서 제거
+        remove_block(ar, next_bp);
+    }
+    if ((n_size - a_size) >= (2 * DSIZE)) { // 남는 부분이 최소 블록 이상이면 떼어서 프리 블록으로
+        PUTTER(HDPT(bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(bp)));
+        next_bp = NEXT_BLKP(bp);
+        PUTTER(HDPT(next_bp), PACK(n_size - a_size, 0) | PREV_ALLOC);
+        PUTTER(FTPT(next_bp), PACK(n_size - a_size, 0));
+        CLR_PREV_ALLOC(HDPT(NEXT_BLKP(next_bp)));
+        coalesce(ar, next_bp); // 그 뒤 블록이 프리면 합쳐짐
+    }
+    else {
+        PUTTER(HDPT(bp), PACK(n_size, 1) | IS_PREV_ALLOCATED(HDPT(bp)));
+        SET_PREV_ALLOC(HDPT(NEXT_BLKP(bp)));
+    }
+    pthread_mutex_unlock(&ar->lock);
+    return 1;
+}
+
+// extend_heap
+static void* extend_heap(arena_t* ar, size_t words) {
     char* bp; // 새로운 블록의 포인터
     size_t size; // 요청된 크기
 
     // 짝수 개의 단어로 크기 조정
     size = (words % 2) ? (words + 1) * WSIZE : words * WSIZE;
-    if ((long)(bp = mem_sbrk(size)) == -1) // 메모리 할당 실패 시
+    if ((long)(bp = arena_sbrk(ar, size)) == -1) // 메모리 할당 실패 시
         return NULL;
 
     // 프리 블록 헤더/풋터와 새로운 에필로그 헤더 초기화
-    PUTTER(HDPT(bp), PACK(size, 0)); // 프리 블록 헤더
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp))); // 프리 블록 헤더
     PUTTER(FTPT(bp), PACK(size, 0)); // 프리 블록 풋터
     PUTTER(HDPT(NEXT_BLKP(bp)), PACK(0, 1)); // 새로운 에필로그 헤더
 
     // 이전 블록이 프리 상태라면 통합
-    return coalesce(bp); // 블록 통합 후 반환
+    return coalesce(ar, bp); // 블록 통합 후 반환
 }
 
 // coalesce
-static void* coalesce(void* bp) {
-    size_t prev_alloc = IS_ALLOCATED(FTPT(PREV_BLKP(bp))); // 이전 블록 할당 여부
+static void* coalesce(arena_t* ar, void* bp) {
+    size_t prev_alloc = IS_PREV_ALLOCATED(HDPT(bp)); // 이전 블록 할당 여부
     size_t next_alloc = IS_ALLOCATED(HDPT(NEXT_BLKP(bp))); // 다음 블록 할당 여부
     size_t size = GET_SIZE(HDPT(bp)); // 현재 블록 크기
 
     if (prev_alloc && next_alloc) { // 이전과 다음 블록 모두 할당된 경우
+        insert_block(ar, bp, size); // 리스트에 추가
         return bp;
     }
 
     else if (prev_alloc && !next_alloc) { // 다음 블록만 프리 상태인 경우
+        remove_block(ar, NEXT_BLKP(bp)); // 다음 블록 리스트에서 제거
         size += GET_SIZE(HDPT(NEXT_BLKP(bp))); // 다음 블록 크기 추가
-        PUTTER(HDPT(bp), PACK(size, 0)); // 현재 블록 헤더 갱신
+        PUTTER(HDPT(bp), PACK(size, 0) | PREV_ALLOC); // 현재 블록 헤더 갱신
         PUTTER(FTPT(bp), PACK(size, 0)); // 현재 블록 풋터 갱신
     }
 
     else if (!prev_alloc && next_alloc) { // 이전 블록만 프리 상태인 경우
+        remove_block(ar, PREV_BLKP(bp)); // 이전 블록 리스트에서 제거
         size += GET_SIZE(HDPT(PREV_BLKP(bp))); // 이전 블록 크기 추가
         PUTTER(FTPT(bp), PACK(size, 0)); // 현재 블록 풋터 갱신
-        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0)); // 이전 블록 헤더 갱신
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC); // 이전 블록 헤더 갱신
         bp = PREV_BLKP(bp); // 블록 포인터 이전 블록으로 이동
     }
 
     else { // 이전과 다음 블록 모두 프리 상태인 경우
+        remove_block(ar, PREV_BLKP(bp)); // 이전 블록 리스트에서 제거
+        remove_block(ar, NEXT_BLKP(bp)); // 다음 블록 리스트에서 제거
         size += GET_SIZE(HDPT(PREV_BLKP(bp))) + GET_SIZE(HDPT(NEXT_BLKP(bp))); // 이전과 다음 블록 크기 추가
-        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0)); // 이전 블록 헤더 갱신
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC); // 이전 블록 헤더 갱신
         PUTTER(FTPT(NEXT_BLKP(bp)), PACK(size, 0)); // 다음 블록 풋터 갱신
         bp = PREV_BLKP(bp); // 블록 포인터 이전 블록으로 이동
     }
 
+    insert_block(ar, bp, size); // 통합된 블록 리스트에 추가
     return bp; // 통합된 블록 반환
 }
 
-// first_fit
-static void* first_fit(size_t a_size) {
+// first_fit : -DNEXT_FIT 이면 요청 리스트를 rover 부터 끝까지, 그 다음 처음부터 rover 앞까지 (next fit)
+static void* first_fit(arena_t* ar, size_t a_size) {
     void* bp; // 블록 포인터
-    for (int i = 0; i < LISTLIMIT; i++) { // 각 리스트 탐색
-        for (bp = segregation_list[i]; bp != NULL; bp = SUCC_FREEPT(bp)) { // 각 블록 탐색
-            if (a_size <= GET_SIZE(HDPT(bp))) { // 적합한 블록 발견 시
-                return bp; // 블록 반환
-            }
+    int i = list_index(a_size); // 요청 크기의 리스트
+    unsigned int map; // 요청 리스트보다 큰 비어있지 않은 리스트들
+#ifdef NEXT_FIT
+    void* start = (ar->rover[i] != NULL) ? ar->rover[i] : ar->segregation_list[i]; // 탐색 시작 블록
+
+    for (bp = start; bp != NULL; bp = SUCC_FREEPT(ar, bp)) {
+        if (a_size <= GET_SIZE(HDPT(bp))) {
+            ar->rover[i] = bp; // place 에서 리스트에서 빠지며 rover 는 다음 블록으로
+            return bp;
+        }
+    }
+    for (bp = ar->segregation_list[i]; bp != start; bp = SUCC_FREEPT(ar, bp)) { // 처음으로 돌아가 rover 앞까지
+        if (a_size <= GET_SIZE(HDPT(bp))) {
+            ar->rover[i] = bp;
+            return bp;
         }
     }
-    return NULL; // 적합한 블록이 없을 경우 NULL 반환
+#else
+    // 리스트는 크기순 정렬이므로 요청 리스트에서 처음 맞는 블록이 가장 작은 블록
+    for (bp = ar->segregation_list[i]; bp != NULL; bp = SUCC_FREEPT(ar, bp)) {
+        if (a_size <= GET_SIZE(HDPT(bp))) {
+            return bp;
+        }
+    }
+#endif
+
+    // 없으면 비트맵으로 바로 위의 비어있지 않은 리스트로 점프해서 맨 앞 블록
+    map = ar->list_bitmap & ~((CLASS_BIT(i) << 1) - 1);
+    if (map == 0) {
+        return NULL; // 적합한 블록이 없을 경우 NULL 반환
+    }
+#ifdef NEXT_FIT
+    i = __builtin_ctz(map);
+    if (ar->rover[i] != NULL) { // 위 리스트도 rover 블록부터 (어느 블록이든 맞음)
+        return ar->rover[i];
+    }
+#endif
+    return ar->segregation_list[__builtin_ctz(map)];
 }
 
 // place
-static void place(void* bp, size_t a_size) {
+static void place(arena_t* ar, void* bp, size_t a_size) {
     size_t csize = GET_SIZE(HDPT(bp)); // 현재 블록 크기
 
+    remove_block(ar, bp); // 할당할 블록이므로 리스트에서 제거
+
     if ((csize - a_size) >= (2 * DSIZE)) { // 블록 분할 가능한 경우
-        PUTTER(HDPT(bp), PACK(a_size, 1)); // 블록 할당 헤더 설정
-        PUTTER(FTPT(bp), PACK(a_size, 1)); // 블록 할당 풋터 설정
+        PUTTER(HDPT(bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(bp))); // 블록 할당 헤더 설정
         bp = NEXT_BLKP(bp); // 블록 포인터 이동
-        PUTTER(HDPT(bp), PACK(csize - a_size, 0)); // 분할된 프리 블록 헤더 설정
+        PUTTER(HDPT(bp), PACK(csize - a_size, 0) | PREV_ALLOC); // 분할된 프리 블록 헤더 설정
         PUTTER(FTPT(bp), PACK(csize - a_size, 0)); // 분할된 프리 블록 풋터 설정
-        insert_block(bp, csize - a_size); // 프리 블록 리스트에 추가
+        insert_block(ar, bp, csize - a_size); // 프리 블록 리스트에 추가
     }
     else { // 블록 분할 불가능한 경우
-        PUTTER(HDPT(bp), PACK(csize, 1)); // 전체 블록 할당 헤더 설정
-        PUTTER(FTPT(bp), PACK(csize, 1)); // 전체 블록 할당 풋터 설정
+        PUTTER(HDPT(bp), PACK(csize, 1) | IS_PREV_ALLOCATED(HDPT(bp))); // 전체 블록 할당 헤더 설정
+        SET_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 할당 블록은 풋터 없이 다음 블록 헤더에 표시
     }
 }
 
+// list_index : 블록 크기에 맞는 분리 리스트 번호
+static int list_index(size_t size) {
+    int i = 31 - __builtin_clz((unsigned int)size | 1); // 최상위 비트 위치 = floor(log2(size))
+
+    return (i < LISTLIMIT - 1) ? i : LISTLIMIT - 1; // 큰 블록은 마지막 리스트로
+}
+
 // remove_block
-static void remove_block(void* bp) {
-    int i = 0; // 리스트 인덱스
-    size_t size = GET_SIZE(HDPT(bp)); // 블록 크기
+static void remove_block(arena_t* ar, void* bp) {
+    int i = list_index(GET_SIZE(HDPT(bp))); // 리스트 인덱스
 
-    while ((i < LISTLIMIT - 1) && (size > 1)) { // 적절한 리스트 인덱스 찾기
-        size >>= 1;
-        i++;
+#ifdef NEXT_FIT
+    if (bp == ar->rover[i]) { // 병합이나 할당으로 rover 블록이 빠지면 다음 블록부터
+        ar->rover[i] = SUCC_FREEPT(ar, bp);
     }
-
-    if (SUCC_FREEPT(bp) != NULL) { // 다음 블록이 존재하는 경우
-        PRED_FREEPT(SUCC_FREEPT(bp)) = PRED_FREEPT(bp); // 이전 블록 연결 갱신
+#endif
+#ifdef ADDRESS_ORDERED
+    if (REGION_FIRST(ar, REGION_OF(ar, bp), i) == bp) { // 칸의 첫 블록이면 주소순 다음 블록이 같은 칸일 때만 물려줌
+        void* next = SUCC_FREEPT(ar, bp);
+        REGION_FIRST(ar, REGION_OF(ar, bp), i)
+            = (next != NULL && REGION_OF(ar, next) == REGION_OF(ar, bp)) ? next : NULL;
+        region_mark(ar, REGION_OF(ar, bp), i);
     }
-    if (PRED_FREEPT(bp) != NULL) { // 이전 블록이 존재하는 경우
-        SUCC_FREEPT(PRED_FREEPT(bp)) = SUCC_FREEPT(bp); // 다음 블록 연결 갱신
+#endif
+    if (SUCC_FREEPT(ar, bp) != NULL) { // 다음 블록이 존재하는 경우
+        SET_PRED_FREEPT(ar, SUCC_FREEPT(ar, bp), PRED_FREEPT(ar, bp)); // 이전 블록 연결 갱신
+    }
+    if (PRED_FREEPT(ar, bp) != NULL) { // 이전 블록이 존재하는 경우
+        SET_SUCC_FREEPT(ar, PRED_FREEPT(ar, bp), SUCC_FREEPT(ar, bp)); // 다음 블록 연결 갱신
     }
     else { // 현재 블록이 리스트의 첫 블록인 경우
-        segregation_list[i] = SUCC_FREEPT(bp); // 리스트 헤더 갱신
+        ar->segregation_list[i] = SUCC_FREEPT(ar, bp); // 리스트 헤더 갱신
+        if (ar->segregation_list[i] == NULL) { // 리스트가 비면 비트맵에서 지우기
+            ar->list_bitmap &= ~CLASS_BIT(i);
+        }
     }
 }
 
 // insert_block
-static void insert_block(void* bp, size_t size) {
-    int i = 0; // 리스트 인덱스
+static void insert_block(arena_t* ar, void* bp, size_t size) {
+    int i = list_index(size); // 리스트 인덱스
     void* search_bp = NULL; // 검색 블록 포인터
     void* insert_bp = NULL; // 삽입 위치 블록 포인터
 
-    while ((i < LISTLIMIT - 1) && (size > 1)) { // 적절한 리스트 인덱스 찾기
-        size >>= 1;
-        i++;
+    ar->list_bitmap |= CLASS_BIT(i); // 비어있지 않은 리스트로 표시
+    if (size >= PURGE_MIN) { // 큰 블록은 리스트에 들어간 시각 기록 (마지막으로 읽은 시각)
+        PURGE_STAMP(bp) = ar->now;
     }
-
-    search_bp = segregation_list[i]; // 리스트 헤더로부터 검색 시작
+#ifdef ADDRESS_ORDERED
+    insert_bp = region_pred(ar, i, bp); // 주소순으로 바로 앞 블록 (없으면 맨 앞에)
+    search_bp = (insert_bp != NULL) ? SUCC_FREEPT(ar, insert_bp) : ar->segregation_list[i];
+    if (REGION_FIRST(ar, REGION_OF(ar, bp), i) == NULL
+        || (char*)bp < (char*)REGION_FIRST(ar, REGION_OF(ar, bp), i)) { // 칸의 첫 블록 갱신
+        REGION_FIRST(ar, REGION_OF(ar, bp), i) = bp;
+        region_mark(ar, REGION_OF(ar, bp), i);
+    }
+#else
+    search_bp = ar->segregation_list[i]; // 리스트 헤더로부터 검색 시작
     while ((search_bp != NULL) && (size > GET_SIZE(HDPT(search_bp)))) { // 적절한 위치 찾기
         insert_bp = search_bp;
-        search_bp = SUCC_FREEPT(search_bp);
+        search_bp = SUCC_FREEPT(ar, search_bp);
     }
+#endif
 
     if (search_bp != NULL) { // 삽입 위치가 리스트 중간인 경우
         if (insert_bp != NULL) { // 삽입 위치가 리스트 중간인 경우
-            SUCC_FREEPT(insert_bp) = bp;
-            PRED_FREEPT(search_bp) = bp;
-            SUCC_FREEPT(bp) = search_bp;
-            PRED_FREEPT(bp) = insert_bp;
+            SET_SUCC_FREEPT(ar, insert_bp, bp);
+            SET_PRED_FREEPT(ar, search_bp, bp);
+            SET_SUCC_FREEPT(ar, bp, search_bp);
+            SET_PRED_FREEPT(ar, bp, insert_bp);
         }
         else { // 삽입 위치가 리스트의 첫 블록인 경우
-            SUCC_FREEPT(bp) = search_bp;
-            PRED_FREEPT(search_bp) = bp;
-            PRED_FREEPT(bp) = NULL;
-            segregation_list[i] = bp;
+            SET_SUCC_FREEPT(ar, bp, search_bp);
+            SET_PRED_FREEPT(ar, search_bp, bp);
+            SET_PRED_FREEPT(ar, bp, NULL);
+            ar->segregation_list[i] = bp;
         }
     }
     else { // 삽입 위치가 리스트의 끝인 경우
         if (insert_bp != NULL) { // 삽입 위치가 리스트 중간인 경우
-            SUCC_FREEPT(insert_bp) = bp;
-            PRED_FREEPT(bp) = insert_bp;
-            SUCC_FREEPT(bp) = NULL;
+            SET_SUCC_FREEPT(ar, insert_bp, bp);
+            SET_PRED_FREEPT(ar, bp, insert_bp);
+            SET_SUCC_FREEPT(ar, bp, NULL);
         }
         else { // 삽입 위치가 리스트의 첫 블록인 경우
-            SUCC_FREEPT(bp) = NULL;
-            PRED_FREEPT(bp) = NULL;
-            segregation_list[i] = bp;
+            SET_SUCC_FREEPT(ar, bp, NULL);
+            SET_PRED_FREEPT(ar, bp, NULL);
+            ar->segregation_list[i] = bp;
         }
     }
 }
+
+#ifdef ADDRESS_ORDERED
+// region_reserve : 아레나가 end 까지 늘어도 모든 칸이 인덱스 배열에 들어가도록 미리 늘림 (비트맵도 같이)
+// 배열 하나만 늘고 실패하면 그 배열은 커진 채로 두고 칸 수는 그대로 (다음에 다시 늘림)
+static int region_reserve(arena_t* ar, char* end) {
+    size_t need = ((size_t)(end - ar->region_base) >> REGION_SHIFT) + 1; // 필요한 칸 수
+    size_t cap = (ar->region_cap != 0) ? ar->region_cap : REGION_MIN; // 새 칸 수
+    size_t bits = LISTLIMIT * sizeof(unsigned long long); // 비트맵 워드 한 줄 (클래스 수만큼)
+    void* p;
+    void* b;
+    void* q;
+
+    if (need <= ar->region_cap) {
+        return 0;
+    }
+    while (cap < need) {
+        cap *= 2;
+    }
+    if (ar->region_first == NULL) { // 익명 매핑이라 0 (빈 칸) 으로 시작
+        p = mmap(NULL, cap * LISTLIMIT * sizeof(void*), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        b = mmap(NULL, (cap >> 6) * bits, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        q = mmap(NULL, ((cap >> 12) + 1) * bits, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    else { // 늘어난 부분도 0 (칸이 바깥 인덱스라 뒤에 붙기만 함)
+        p = mremap(ar->region_first, ar->region_cap * LISTLIMIT * sizeof(void*),
+            cap * LISTLIMIT * sizeof(void*), MREMAP_MAYMOVE);
+        b = mremap(ar->region_bits, (ar->region_cap >> 6) * bits, (cap >> 6) * bits, MREMAP_MAYMOVE);
+        q = mremap(ar->region_sum, ((ar->region_cap >> 12) + 1) * bits, ((cap >> 12) + 1) * bits, MREMAP_MAYMOVE);
+    }
+    if (p != MAP_FAILED) {
+        ar->region_first = p;
+    }
+    if (b != MAP_FAILED) {
+        ar->region_bits = b;
+    }
+    if (q != MAP_FAILED) {
+        ar->region_sum = q;
+    }
+    if (p == MAP_FAILED || b == MAP_FAILED || q == MAP_FAILED) {
+        return -1;
+    }
+    ar->region_cap = cap;
+    return 0;
+}
+
+// region_mark : r 칸 i 클래스에 첫 블록이 생겼거나 없어졌으면 비트맵에 반영
+static void region_mark(arena_t* ar, size_t r, int i) {
+    if (REGION_FIRST(ar, r, i) != NULL) {
+        REGION_BITS(ar, r >> 6, i) |= BIT(r);
+        REGION_SUM(ar, r >> 12, i) |= BIT(r >> 6);
+    }
+    else {
+        REGION_BITS(ar, r >> 6, i) &= ~BIT(r);
+        if (REGION_BITS(ar, r >> 6, i) == 0) { // 워드가 비었으면 요약에서도
+            REGION_SUM(ar, r >> 12, i) &= ~BIT(r >> 6);
+        }
+    }
+}
+
+// region_before : i 클래스에서 r 칸보다 앞쪽으로 첫 블록이 있는 가장 가까운 칸 (없으면 -1)
+// 같은 워드 -> 같은 요약 워드 -> 앞 요약 워드들 (요약 워드 하나가 칸 4096 개) 순서로 clz
+static long region_before(arena_t* ar, size_t r, int i) {
+    size_t w = r >> 6; // REGION_BITS 워드
+    size_t v = r >> 12; // REGION_SUM 워드
+    unsigned long long m = REGION_BITS(ar, w, i) & (BIT(r) - 1); // 같은 워드의 앞 칸들
+
+    if (m == 0) {
+        m = REGION_SUM(ar, v, i) & (BIT(w) - 1); // 같은 요약 워드의 앞 워드들
+        while (m == 0) {
+            if (v == 0) {
+                return -1;
+            }
+            m = REGION_SUM(ar, --v, i);
+        }
+        w = (v << 6) + 63 - __builtin_clzll(m);
+        m = REGION_BITS(ar, w, i);
+    }
+    return (long)((w << 6) + 63 - __builtin_clzll(m));
+}
+
+// region_pred : i 클래스에서 bp 보다 주소가 작은 블록 중 가장 뒤 블록 (없으면 NULL)
+static void* region_pred(arena_t* ar, int i, void* bp) {
+    size_t r = REGION_OF(ar, bp);
+    void* p = REGION_FIRST(ar, r, i); // 걷기 시작할 블록
+
+    if (p == NULL || (char*)p > (char*)bp) { // 같은 칸에 앞 블록이 없으면 앞쪽으로 가장 가까운 칸
+        long q = region_before(ar, r, i);
+
+        if (q < 0) {
+            return NULL;
+        }
+        p = REGION_FIRST(ar, q, i);
+    }
+    // 그 칸 안에서 bp 바로 앞까지 (사이 칸들은 비어 있으므로 칸 하나만 걸음)
+    while (SUCC_FREEPT(ar, p) != NULL && (char*)SUCC_FREEPT(ar, p) < (char*)bp) {
+        p = SUCC_FREEPT(ar, p);
+    }
+    return p;
+}
+#endif
+
+/////// 스레드 캐시
+// 캐시에 든 블록은 힙 입장에서는 "할당된" 블록이라 이웃과 병합되지 않고,
+// 캐시가 넘칠 때나 스레드가 끝날 때 heap_free 로 한꺼번에 돌려준다.
+
+// tcache_key_init : 스레드 종료 콜백 키 생성 (한 번만)
+static void tcache_key_init(void) {
+    pthread_key_create(&tcache_key, tcache_flush);
+}
+
+// tcache_attach : 현재 스레드가 끝날 때 tcache_flush 가 불리도록 등록
+static void tcache_attach(void) {
+    if (tcache_attached) {
+        return;
+    }
+    pthread_once(&tcache_once, tcache_key_init);
+    pthread_setspecific(tcache_key, &tcache);
+    tcache_attached = 1;
+}
+
+// tc_round : 캐시를 거치는 블록 크기를 칸 크기로 올림 (마지막 칸 위는 TCACHE_MAX 가 되어 캐시를 안 거침)
+static size_t tc_round(size_t a_size) {
+    size_t step; // 칸 폭
+
+    if (a_size >= TCACHE_MAX) {
+        return a_size;
+    }
+    step = (a_size < TCACHE_EXACT) ? DSIZE : (size_t)1 << (31 - __builtin_clz((unsigned int)a_size) - TCACHE_SUB);
+    return (a_size + step - 1) & ~(step - 1);
+}
+
+// tc_bin : size 이하 가장 큰 칸 크기의 캐시 칸 (칸 크기면 그 칸)
+static int tc_bin(size_t size) {
+    int msb; // floor(log2(size))
+
+    if (size < TCACHE_EXACT) {
+        return (int)(size / DSIZE);
+    }
+    msb = 31 - __builtin_clz((unsigned int)size);
+    return TCACHE_EXACT / DSIZE + ((msb - TCACHE_SUB - 3) << TCACHE_SUB)
+        + (int)((size >> (msb - TCACHE_SUB)) & ((1 << TCACHE_SUB) - 1));
+}
+
+// tcache_get : i번 칸 맨 위 블록 꺼내기 (칸의 블록은 모두 칸 크기 이상이라 크기를 확인하지 않음)
+static void* tcache_get(int i) {
+    void* bp = tcache.bin[i];
+
+    if (bp == NULL) {
+        return NULL;
+    }
+    tcache.bin[i] = TC_NEXT(bp);
+    tcache.count[i]--;
+    return bp;
+}
+
+// tcache_refill : 아레나 락 한 번으로 a_size 블록을 최대 TCACHE_BATCH 개 할당해 캐시에 채우기
+static void tcache_refill(int i, size_t a_size) {
+    void* bp;
+
+    arena_t* ar = thread_arena();
+
+    tcache_attach();
+    pthread_mutex_lock(&ar->lock);
+    for (int n = 0; n < TCACHE_BATCH && tcache.count[i] < TCACHE_COUNT; n++) {
+        if ((bp = heap_malloc(ar, a_size)) == NULL) { // 힙 확장 실패하면 있는 만큼만
+            break;
+        }
+        TC_NEXT(bp) = tcache.bin[i];
+        tcache.bin[i] = bp;
+        tcache.count[i]++;
+    }
+    pthread_mutex_unlock(&ar->lock);
+}
+
+// tcache_drain : i번 캐시에서 n개를 주인 아레나에 반환 (병합은 여기서)
+// 다른 스레드가 할당한 블록이 섞여 있을 수 있으므로 주인이 바뀔 때만 락을 바꿔 잡음
+static void tcache_drain(tcache_t* tc, int i, int n) {
+    void* bp;
+    arena_t* ar;
+    arena_t* locked = NULL;
+
+    while (n-- > 0 && (bp = tc->bin[i]) != NULL) {
+        tc->bin[i] = TC_NEXT(bp);
+        tc->count[i]--;
+        ar = arena_of(bp);
+        if (ar != locked) {
+            if (locked != NULL) {
+                pthread_mutex_unlock(&locked->lock);
+            }
+            pthread_mutex_lock(&ar->lock);
+            locked = ar;
+        }
+        heap_free(ar, bp);
+    }
+    if (locked != NULL) {
+        pthread_mutex_unlock(&locked->lock);
+    }
+}
+
+// tcache_flush : 스레드 종료 시 남은 캐시 블록 전부 반환
+static void tcache_flush(void* arg) {
+    tcache_t* tc = arg;
+
+    for (int i = 0; i < TCACHE_BINS; i++) {
+        tcache_drain(tc, i, tc->count[i]);
+    }
+}
+
+/////// 아레나
+
+// arena_lock_init : 아레나 락 초기화 (한 번만)
+static void arena_lock_init(void) {
+    for (int k = 0; k < ARENA_MAX; k++) {
+        pthread_mutex_init(&arenas[k].lock, NULL);
+        for (int c = 0; c < SMALL_CLASSES; c++) {
+            pthread_mutex_init(&arenas[k].small[c].lock, NULL);
+        }
+    }
+}
+
+// mm_atfork_prepare : fork 직전 모든 락 잡기 (다른 스레드가 잡은 채로 자식에 복사되지 않게)
+// 순서 고정 : 아레나 락 (0번부터) -> 아레나별 클래스 락 -> slab_lock
+// 아레나 락끼리, 아레나 락과 클래스 락은 겹쳐 잡지 않고 클래스 락 안에서만 slab_lock 을 잡으므로 교착 없음
+void mm_atfork_prepare(void) {
+    pthread_once(&arena_once, arena_lock_init); // mm_init 전에 fork 해도 락은 초기화된 상태로
+    for (int k = 0; k < ARENA_MAX; k++) {
+        pthread_mutex_lock(&arenas[k].lock);
+    }
+    for (int k = 0; k < ARENA_MAX; k++) {
+        for (int c = 0; c < SMALL_CLASSES; c++) {
+            pthread_mutex_lock(&arenas[k].small[c].lock);
+        }
+    }
+    pthread_mutex_lock(&slab_lock);
+}
+
+// mm_atfork_parent : 부모는 잡은 반대 순서로 풀기
+void mm_atfork_parent(void) {
+    pthread_mutex_unlock(&slab_lock);
+    for (int k = ARENA_MAX - 1; k >= 0; k--) {
+        for (int c = SMALL_CLASSES - 1; c >= 0; c--) {
+            pthread_mutex_unlock(&arenas[k].small[c].lock);
+        }
+    }
+    for (int k = ARENA_MAX - 1; k >= 0; k--) {
+        pthread_mutex_unlock(&arenas[k].lock);
+    }
+}
+
+// mm_atfork_child : 자식은 fork 한 스레드 하나뿐이므로 락을 새로 초기화
+void mm_atfork_child(void) {
+    pthread_mutex_init(&slab_lock, NULL);
+    arena_lock_init();
+}
+
+// arena_init : 아레나에 프롤로그/에필로그를 만들고 첫 청크 확장
+static int arena_init(arena_t* ar) {
+    char* heap_list;
+
+    for (int i = 0; i < LISTLIMIT; i++) {
+        ar->segregation_list[i] = NULL;
+#ifdef NEXT_FIT
+        ar->rover[i] = NULL;
+#endif
+    }
+    ar->list_bitmap = 0;
+    ar->now = ar->last_decay = now_ms();
+#ifdef ADDRESS_ORDERED
+    ar->region_base = (ar == &arenas[0]) ? (char*)mem_heap_lo() : ar->brk;
+    if (ar->region_first != NULL) { // 이전 힙의 인덱스 비우기
+        memset(ar->region_first, 0, ar->region_cap * LISTLIMIT * sizeof(void*));
+        memset(ar->region_bits, 0, (ar->region_cap >> 6) * LISTLIMIT * sizeof(unsigned long long));
+        memset(ar->region_sum, 0, ((ar->region_cap >> 12) + 1) * LISTLIMIT * sizeof(unsigned long long));
+    }
+#endif
+
+    // 메모리 확장 실패
+    if ((heap_list = arena_sbrk(ar, 4 * WSIZE)) == (void*)-1) {
+        return -1;
+    }
+
+    PUTTER(heap_list, 0);                             // 시작 부분
+    PUTTER(heap_list + (1 * WSIZE), PACK(DSIZE, 1));  // 맨 앞 헤더 할당된 것
+    PUTTER(heap_list + (2 * WSIZE), PACK(DSIZE, 1));  // 풋터
+    PUTTER(heap_list + (3 * WSIZE), PACK(0, 1) | PREV_ALLOC);      // 뒷부분 헤더
+
+    ar->heap_list = heap_list + (2 * WSIZE); // 힙 리스트의 포인터를 맨 앞 블록의 끝으로
+
+    if (extend_heap(ar, CHUNKSIZE / WSIZE) == NULL) { // 확장 ~
+        return -1;
+    }
+    return 0;
+}
+
+// arena_sbrk : 아레나 힙을 size 만큼 늘리기 (mem_sbrk 와 같은 약속, 실패하면 (void*)-1)
+static void* arena_sbrk(arena_t* ar, size_t size) {
+    char* old_brk = ar->brk;
+
+#ifdef ADDRESS_ORDERED
+    // 늘어난 아레나까지 인덱스 확보
+    if (region_reserve(ar, ((ar == &arenas[0]) ? (char*)mem_heap_hi() + 1 : ar->brk) + size) == -1) {
+        errno = ENOMEM;
+        return (void*)-1;
+    }
+#endif
+    if (ar == &arenas[0]) { // 0번 아레나는 원래 힙
+        return mem_sbrk(size);
+    }
+    if (size > (size_t)(ar->limit - ar->brk)) { // 예약한 영역을 넘으면 실패
+        errno = ENOMEM;
+        return (void*)-1;
+    }
+    ar->brk += size;
+    return old_brk;
+}
+
+// arena_of : 블록 주소로 주인 아레나 찾기
+static arena_t* arena_of(void* bp) {
+    char* p = bp;
+
+    if (arena_base != NULL && p >= arena_base && p < arena_base + (size_t)(ARENA_MAX - 1) * ARENA_SPAN) {
+        return &arenas[1 + (p - arena_base) / ARENA_SPAN];
+    }
+    return &arenas[0];
+}
+
+// thread_arena : 현재 스레드의 아레나 (처음 부르면 라운드 로빈으로 배정)
+static arena_t* thread_arena(void) {
+    if (my_arena == NULL) {
+        my_arena = &arenas[__sync_fetch_and_add(&next_arena, 1) % narenas];
+    }
+    return my_arena;
+}
+
+/////// 작은 객체 (slab)
+
+// small_malloc : 현재 스레드 아레나의 클래스에서 슬롯 하나 꺼내기
+static void* small_malloc(size_t size) {
+    int cls = SMALL_CLASS(size);
+    small_bin_t* bin = &thread_arena()->small[cls];
+    run_t* r;
+    void* bp;
+
+    pthread_mutex_lock(&bin->lock);
+    if ((r = bin->partial) == NULL) { // 빈 슬롯 있는 run 이 없으면 새 run
+        if ((r = run_new(bin, cls)) == NULL) {
+            pthread_mutex_unlock(&bin->lock);
+            return NULL;
+        }
+        bin->partial = r;
+    }
+
+    if (r->free_slot != NULL) { // 해제된 슬롯 먼저
+        bp = r->free_slot;
+        r->free_slot = SLOT_NEXT(bp);
+    }
+    else { // 없으면 아직 안 쓴 슬롯
+        bp = (char*)r + RUN_HDR + (size_t)r->bump * SLOT_SIZE(cls);
+        r->bump++;
+    }
+
+    if (--r->nfree == 0) { // 꽉 찬 run 은 리스트에서 빼기
+        bin->partial = r->next;
+        if (r->next != NULL) {
+            r->next->prev = NULL;
+        }
+    }
+    pthread_mutex_unlock(&bin->lock);
+    return bp;
+}
+
+// small_free : 슬롯을 run 의 빈 슬롯 스택에 돌려주기
+static void small_free(void* bp) {
+    run_t* r = RUN_OF(bp);
+    small_bin_t* bin = r->bin;
+
+    pthread_mutex_lock(&bin->lock);
+    SLOT_NEXT(bp) = r->free_slot;
+    r->free_slot = bp;
+
+    if (r->nfree++ == 0) { // 꽉 찼던 run 이면 다시 리스트 맨 앞으로
+        r->prev = NULL;
+        r->next = bin->partial;
+        if (bin->partial != NULL) {
+            bin->partial->prev = r;
+        }
+        bin->partial = r;
+    }
+    else if (r->nfree == r->nslots && (r->prev != NULL || r->next != NULL)) {
+        // 다 빈 run 은 돌려주기 (클래스에 run 이 하나뿐이면 재사용을 위해 남김)
+        if (r->prev != NULL) {
+            r->prev->next = r->next;
+        }
+        else {
+            bin->partial = r->next;
+        }
+        if (r->next != NULL) {
+            r->next->prev = r->prev;
+        }
+        run_release(r);
+    }
+    pthread_mutex_unlock(&bin->lock);
+}
+
+// run_new : 빈 run 하나를 cls 클래스용으로 초기화
+static run_t* run_new(small_bin_t* bin, int cls) {
+    run_t* r;
+
+    pthread_mutex_lock(&slab_lock);
+    if (free_runs != NULL) { // 돌려받은 run 재사용
+        r = free_runs;
+        free_runs = r->next;
+    }
+    else if (slab_brk + RUN_SIZE <= slab_base + SLAB_SPAN) { // 예약 영역에서 새로 자르기
+        r = (run_t*)slab_brk;
+        slab_brk += RUN_SIZE;
+    }
+    else {
+        r = NULL;
+    }
+    pthread_mutex_unlock(&slab_lock);
+
+    if (r == NULL) {
+        return NULL;
+    }
+    r->next = NULL;
+    r->prev = NULL;
+    r->bin = bin;
+    r->free_slot = NULL;
+    r->cls = cls;
+    r->nslots = (RUN_SIZE - RUN_HDR) / SLOT_SIZE(cls);
+    r->nfree = r->nslots;
+    r->bump = 0;
+    return r;
+}
+
+// run_release : 다 빈 run 을 다른 클래스가 쓸 수 있게 반환
+static void run_release(run_t* r) {
+    pthread_mutex_lock(&slab_lock);
+    r->next = free_runs;
+    free_runs = r;
+    pthread_mutex_unlock(&slab_lock);
+}
+
+/////// 큰 블록 (mmap)
+
+// mmap_malloc : size 요청을 전용 매핑 하나로
+static void* mmap_malloc(size_t size) {
+    size_t len; // 헤더 포함 페이지 단위 크기
+    char* p;
+
+    if (size > (size_t)-1 - DSIZE - PAGE_BYTES) { // 페이지 올림이 넘침
+        return NULL;
+    }
+    len = PAGE_ROUND(size + DSIZE);
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+    MMAP_PUT(p + DSIZE, len); // 페이로드 바로 앞 더블 워드 헤더
+    __atomic_add_fetch(&mmap_bytes, len, __ATOMIC_RELAXED);
+    return p + DSIZE;
+}
+
+// mmap_free : 매핑 반환, 임계값보다 큰 블록이면 임계값을 올림
+static void mmap_free(void* bp) {
+    size_t len = MMAP_SIZE(bp);
+    size_t t = __atomic_load_n(&mmap_threshold, __ATOMIC_RELAXED);
+
+    if (len > t && len <= MMAP_THRESHOLD_MAX) {
+        __atomic_store_n(&mmap_threshold, len, __ATOMIC_RELAXED);
+    }
+    munmap((char*)bp - DSIZE, len);
+    __atomic_sub_fetch(&mmap_bytes, len, __ATOMIC_RELAXED);
+}
+
+// mmap_realloc : mremap 으로 늘리거나 줄임 (커널이 페이지를 옮기므로 memcpy 없음)
+static void* mmap_realloc(void* bp, size_t size) {
+    size_t len = MMAP_SIZE(bp); // 지금 매핑 크기
+    size_t new_len; // 새 매핑 크기
+    char* p;
+
+    if (size > (size_t)-1 - DSIZE - PAGE_BYTES) {
+        return NULL;
+    }
+    new_len = PAGE_ROUND(size + DSIZE);
+    if (new_len == len) {
+        return bp;
+    }
+    p = mremap((char*)bp - DSIZE, len, new_len, MREMAP_MAYMOVE);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+    MMAP_PUT(p + DSIZE, new_len);
+    __atomic_add_fetch(&mmap_bytes, new_len - len, __ATOMIC_RELAXED); // 줄었으면 넘쳐서 빼기가 됨
+    return p + DSIZE;
+}
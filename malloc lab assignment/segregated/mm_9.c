@@ -1,10 +1,19 @@
 // Segregated List - best fit
+// + TREE_MIN 보다 작은 프리 블록은 정확한 크기별 리스트 (ALIGNMENT 간격) 라 넣기는 맨 앞에 O(1), 리스트 맨 앞이 딱 맞는 블록
+//   맞는 크기 리스트가 비었으면 비트맵으로 바로 위의 비어있지 않은 리스트, 그래도 없으면 트리 (리스트를 걷지 않음)
+// + 빌드 옵션 -DALIGNMENT=16 (또는 32) : 페이로드 정렬과 블록 크기 단위 (기본 8)
+// + 빌드 옵션 -DADDRESS_ORDERED : 작은 블록 리스트를 LIFO 대신 주소순으로 (칸별 첫 블록 인덱스로 넣을 자리 찾기)
+//   리스트 맨 앞이 같은 크기 중 주소가 가장 작은 블록 (트리는 원래 (크기, 주소) 순)
+
+#define _GNU_SOURCE // mremap
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
 
 #include <sys/mman.h>
 #include <errno.h>
@@ -13,17 +22,37 @@
 #include "memlib.h"
 
 
-// 이미 있던 !
+// 이미 있던 ! (정렬은 빌드 옵션으로 8 / 16 / 32)
+#ifndef ALIGNMENT
 #define ALIGNMENT 8
-#define ALIGN(size) (((size) + (ALIGNMENT-1)) & ~0x7)
+#endif
+#if ALIGNMENT < 8 || ALIGNMENT > 32 || (ALIGNMENT & (ALIGNMENT - 1)) != 0
+#error "ALIGNMENT 은 8, 16, 32 중 하나"
+#endif
+#define ALIGN(size) (((size) + (ALIGNMENT-1)) & ~(size_t)(ALIGNMENT-1))
 #define SIZE_T_SIZE (ALIGN(sizeof(size_t)))
 
 /////// 워드, 헤더, 푸터 / 더블 워드 / 힙 확장 기본 바이트
 #define WSIZE       4           
 #define DSIZE       8           
 #define CHUNKSIZE   (1 << 12)   
+#define MIN_BLOCK   MAX(2 * DSIZE, ALIGNMENT)   // 최소 블록 (헤더 + 이전 + 다음 + 풋터, 정렬 단위 이상)
+
+#define LISTLIMIT   (TREE_MIN / ALIGNMENT)  // 분리 리스트 개수 (블록 크기 / ALIGNMENT 가 리스트 번호, 비트맵 64비트 이하)
+#define CLASS_BIT(i)    (1ull << (i))   // 리스트 비트맵에서 i번 리스트 비트
 
 #define MAX(x, y)   ((x) > (y) ? (x) : (y))   
+#define MIN(x, y)   ((x) < (y) ? (x) : (y))
+
+// 요청 크기 -> 블록 크기 (할당 블록은 헤더만 있으므로 size + WSIZE 를 정렬 단위로 올림, 최소 블록 이상)
+#define BLOCK_SIZE(size)    ((size) + WSIZE <= MIN_BLOCK ? MIN_BLOCK : ALIGN((size) + WSIZE))
+
+/////// quick list : 최근 해제된 작은 블록을 병합 없이 크기별로 모아 두었다가 같은 크기 요청에 바로 재사용
+#define QUICK_MAX   64                      // quick list 로 처리하는 최대 블록 크기
+#define QUICK_LISTS (QUICK_MAX / DSIZE + 1) // 블록 크기 / DSIZE 가 리스트 번호 (정확히 같은 크기만)
+#define QUICK_LIMIT 128                     // 모인 블록 수가 이보다 많아지면 전부 병합 (consolidate)
+
+#define QUICK_NEXT(bp) (*(void**)(bp)) // quick list 안 다음 블록 (할당 상태 블록의 페이로드 첫 칸)
 
 // 정보 (블록 사이즈와 할당 여부에 대한 정보를 헤더와 풋터에 넣어야 함)
 #define PACK(size, alloc)   ((size) | (alloc))
@@ -33,6 +62,11 @@
 
 #define GET_SIZE(p)    (GETTER(p) & ~0x7)   // 블록 크기
 #define IS_ALLOCATED(p)   (GETTER(p) & 0x1)  // 블록 할당 여부
+#define IS_PREV_ALLOCATED(p)   (GETTER(p) & 0x2)   // 이전 블록 할당 여부 (헤더에만 기록)
+#define PREV_ALLOC  0x2   // 헤더의 이전 블록 할당 비트
+
+#define SET_PREV_ALLOC(p)   PUTTER(p, GETTER(p) | PREV_ALLOC)   // 이전 블록 할당 표시
+#define CLR_PREV_ALLOC(p)   PUTTER(p, GETTER(p) & ~PREV_ALLOC)  // 이전 블록 프리 표시
 
 #define HDPT(bp)    ((char *)(bp) - WSIZE)  // 헤더 포인터
 #define FTPT(bp)    ((char *)(bp) + GET_SIZE(HDPT(bp)) - DSIZE)  // 풋터 포인터
@@ -40,41 +74,137 @@
 #define NEXT_BLKP(bp)   (((char *)(bp) + GET_SIZE((char *)(bp) - WSIZE)))   // 다음 블록 포인터 
 #define PREV_BLKP(bp)   (((char *)(bp) - GET_SIZE((char *)(bp) - DSIZE)))   // 이전 블록 포인터
 
-#define PRED_FREEPT(bp) (*(void**)(bp)) // 이전 프리블록 포인터
-#define SUCC_FREEPT(bp) (*(void**)(bp + WSIZE)) // 다음 프리블록 포인터
+// 프리 블록 링크는 포인터 대신 heap_list 로부터의 오프셋 / DSIZE 를 한 워드에 (0 은 NULL)
+// 64비트에서도 최소 블록 16바이트 (헤더 + 이전 + 다음 + 풋터) 그대로, 대신 힙은 heap_list 부터 32GB (2^32 * DSIZE) 까지
+#define TO_LINK(p)      ((p) == NULL ? 0u : (unsigned int)(((char*)(p) - (char*)heap_list) / DSIZE))
+#define FROM_LINK(v)    ((v) == 0 ? NULL : (void*)((char*)heap_list + (size_t)(v) * DSIZE))
+
+#define PRED_FREEPT(bp) FROM_LINK(GETTER(bp)) // 이전 프리블록 포인터
+#define SUCC_FREEPT(bp) FROM_LINK(GETTER((char*)(bp) + WSIZE)) // 다음 프리블록 포인터
+#define SET_PRED_FREEPT(bp, p)  PUTTER(bp, TO_LINK(p))
+#define SET_SUCC_FREEPT(bp, p)  PUTTER((char*)(bp) + WSIZE, TO_LINK(p))
+
+/////// 큰 프리 블록 트리 : TREE_MIN 이상 프리 블록은 리스트 대신 red-black 트리에 (키 = (크기, 주소))
+#define TREE_MIN    512     // 트리로 관리하는 최소 블록 크기
+#define RED         1
+#define BLACK       0
+
+#define TO_TREE_LINK(p)     ((p) == TREE_NIL ? 0u : TO_LINK(p))       // 트리 링크는 0 이 잎 센티넬 (힙 밖)
+#define FROM_TREE_LINK(v)   ((v) == 0 ? TREE_NIL : FROM_LINK(v))
+
+#define TREE_LEFT(bp)   FROM_TREE_LINK(GETTER(bp))                          // 왼쪽 자식
+#define TREE_RIGHT(bp)  FROM_TREE_LINK(GETTER((char*)(bp) + 1 * WSIZE))     // 오른쪽 자식
+#define TREE_PARENT(bp) FROM_TREE_LINK(GETTER((char*)(bp) + 2 * WSIZE))     // 부모
+#define SET_TREE_LEFT(bp, p)    PUTTER(bp, TO_TREE_LINK(p))
+#define SET_TREE_RIGHT(bp, p)   PUTTER((char*)(bp) + 1 * WSIZE, TO_TREE_LINK(p))
+#define SET_TREE_PARENT(bp, p)  PUTTER((char*)(bp) + 2 * WSIZE, TO_TREE_LINK(p))
+#define TREE_COLOR(bp)  (*(unsigned int*)((char*)(bp) + 3 * WSIZE)) // 색
+#define TREE_NIL        ((void*)tree_nil)                           // 잎 (검은색 센티넬)
+
+// a 가 b 보다 앞인지 : 크기가 작거나, 크기가 같으면 주소가 작은 쪽
+#define TREE_LESS(a, b) (GET_SIZE(HDPT(a)) < GET_SIZE(HDPT(b)) \
+                        || (GET_SIZE(HDPT(a)) == GET_SIZE(HDPT(b)) && (char*)(a) < (char*)(b)))
+
+/////// 주소순 리스트 (-DADDRESS_ORDERED, TREE_MIN 보다 작은 블록 리스트만)
+// 힙을 REGION_SIZE 칸으로 나눠 (칸, 클래스) 마다 주소가 가장 작은 프리 블록을 기억해 두고,
+// 넣을 때는 같은 칸(없으면 앞쪽으로 가장 가까운 칸)의 그 클래스 첫 블록부터 걸어서 자리를 찾음
+#define REGION_SHIFT    16                      // 칸 크기 64KB (칸마다 LISTLIMIT 개 포인터)
+#define REGION_MIN      64                      // 인덱스 배열 처음 칸 수 (모자라면 두 배씩 mremap)
+#define REGION_OF(bp)   ((size_t)((char*)(bp) - (char*)mem_heap_lo()) >> REGION_SHIFT)   // 블록이 속한 칸
+#define REGION_FIRST(r, i)  (region_first[(r) * LISTLIMIT + (i)])   // r 칸 i 클래스 첫 블록
+// 앞쪽으로 가장 가까운 칸은 클래스마다 두 단계 비트맵에서 clz 로 (칸 하나씩 거꾸로 걷지 않음)
+#define REGION_BITS(w, i)   (region_bits[(w) * LISTLIMIT + (i)])    // i 클래스 칸 64개 (w 워드) 중 첫 블록이 있는 칸 비트
+#define REGION_SUM(v, i)    (region_sum[(v) * LISTLIMIT + (i)])     // i 클래스 REGION_BITS 워드 64개 (v 요약 워드) 중 0 이 아닌 워드 비트
+#define BIT(n)              (1ull << ((n) & 63))    // 64비트 워드 안 n 번 비트
 
 static void* heap_list = NULL; // 힙 리스트 시작 포인터
+static void* quick_list[QUICK_LISTS]; // 크기별 quick list (LIFO)
+static int quick_count; // quick list 에 모인 블록 수
 static void* segregation_list[LISTLIMIT];
+static unsigned long long list_bitmap; // 비어있지 않은 리스트 비트맵
+static void* tree_nil[4]; // 잎 센티넬 노드
+static void* tree_root; // 트리 루트
+#ifdef ADDRESS_ORDERED
+static void** region_first; // (칸, 클래스) 별 주소가 가장 작은 프리 블록 (mmap, mm_init 이 다시 불려도 재사용)
+static size_t region_cap; // 인덱스 배열 칸 수
+static unsigned long long* region_bits; // REGION_BITS (칸 64개마다 클래스 수만큼 워드)
+static unsigned long long* region_sum; // REGION_SUM (칸 4096개마다 클래스 수만큼 워드)
+#endif
 
-static int mm_init(void);
+int mm_init(void);
 static void* extend_heap(size_t words);
 static void* coalesce(void* bp);
 void* mm_malloc(size_t size);
 static void* best_fit(size_t a_size);
 static void place(void* bp, size_t a_size);
 void mm_free(void* bp);
+static void free_block(void* bp);
+static void consolidate(void);
 void* mm_realloc(void* bp, size_t size);
+size_t mm_malloc_batch(size_t size, size_t n, void** out);
+int mm_malloc_multi(size_t n, const size_t* sizes, void** out);
+void mm_free_batch(void** ptrs, size_t n);
+static void* batch_block(size_t total);
+static void place_batch(void* bp, size_t k, size_t a_size, const size_t* sizes, void** out);
+static int ptr_cmp(const void* a, const void* b);
+void* mm_memalign(size_t alignment, size_t size);
+void* mm_aligned_alloc(size_t alignment, size_t size);
+static void* aligned_fit(size_t alignment, size_t a_size);
+static char* aligned_payload(void* bp, size_t alignment);
+static void* place_aligned(void* bp, size_t alignment, size_t a_size);
 
 
+static int list_index(size_t size);
 static void remove_block(void* bp);
 static void insert_block(void* bp, size_t size);
 
+static void tree_insert(void* bp);
+static void tree_remove(void* bp);
+static void* tree_lower_bound(size_t a_size);
+static void tree_rotate_left(void* x);
+static void tree_rotate_right(void* x);
+static void tree_transplant(void* u, void* v);
+
+#ifdef ADDRESS_ORDERED
+static int region_reserve(size_t incr);
+static void region_mark(size_t r, int i);
+static long region_before(size_t r, int i);
+static void* region_pred(int i, void* bp);
+#endif
+
 // mm_init
 int mm_init(void)
 {
+    for (int i = 0; i < QUICK_LISTS; i++) { // quick list 비우기
+        quick_list[i] = NULL;
+    }
+    quick_count = 0;
+
+    for (int i = 0; i < LISTLIMIT; i++) { // 분리 리스트 비우기
+        segregation_list[i] = NULL;
+    }
+    list_bitmap = 0;
+    tree_root = TREE_NIL;
+#ifdef ADDRESS_ORDERED
+    if (region_first != NULL) { // 이전 힙의 인덱스 비우기
+        memset(region_first, 0, region_cap * LISTLIMIT * sizeof(void*));
+        memset(region_bits, 0, (region_cap >> 6) * LISTLIMIT * sizeof(unsigned long long));
+        memset(region_sum, 0, ((region_cap >> 12) + 1) * LISTLIMIT * sizeof(unsigned long long));
+    }
+#endif
+
     // 메모리 확장 실패
-    if ((heap_list = mem_sbrk(6 * WSIZE)) == (void*)-1) {
+    // 맨 앞 블록은 ALIGNMENT 크기, 페이로드가 힙 시작 + ALIGNMENT 이므로 뒤 블록 페이로드도 모두 정렬 (memlib 힙 시작은 페이지 정렬)
+    if ((heap_list = mem_sbrk(2 * ALIGNMENT)) == (void*)-1) {
         return -1;
     }
 
     PUTTER(heap_list, 0);                             // 시작 부분
-    PUTTER(heap_list + (1 * WSIZE), PACK(2 * DSIZE, 1)); // 맨 앞 헤더 할당된 것
-    PUTTER(heap_list + (2 * WSIZE), NULL);            // 이전 포인터 null
-    PUTTER(heap_list + (3 * WSIZE), NULL);            // 이후 포인터 null
-    PUTTER(heap_list + (4 * WSIZE), PACK(2 * DSIZE, 1));  // 풋터 
-    PUTTER(heap_list + (5 * WSIZE), PACK(0, 1));      // 뒷부분 헤더
+    PUTTER(heap_list + ALIGNMENT - WSIZE, PACK(ALIGNMENT, 1));  // 맨 앞 헤더 할당된 것
+    PUTTER(heap_list + 2 * ALIGNMENT - DSIZE, PACK(ALIGNMENT, 1));  // 풋터
+    PUTTER(heap_list + 2 * ALIGNMENT - WSIZE, PACK(0, 1) | PREV_ALLOC);      // 뒷부분 헤더
 
-    free_list = heap_list + (2 * WSIZE); // 프리 블록 리스트의 시작을 맨 앞 다음 첫 프리블록으로
+    heap_list += ALIGNMENT; // 힙 리스트의 포인터를 맨 앞 블록의 페이로드로
 
     if (extend_heap(CHUNKSIZE / WSIZE) == NULL) // 확장 ~
         return -1;
@@ -87,13 +217,18 @@ static void* extend_heap(size_t words) {
     char* bp; // 새로운 블록의 포인터
     size_t size; // 요청된 크기
 
-    // 짝수 개의 단어로 크기 조정
-    size = (words % 2) ? (words + 1) * WSIZE : words * WSIZE;
+    // 정렬 단위 배수로 크기 조정
+    size = ALIGN(words * WSIZE);
+#ifdef ADDRESS_ORDERED
+    if (region_reserve(size) == -1) { // 늘어난 힙까지 인덱스 확보
+        return NULL;
+    }
+#endif
     if ((long)(bp = mem_sbrk(size)) == -1) // 메모리 할당 실패 시
         return NULL;
 
     // 프리 블록 헤더/풋터와 새로운 에필로그 헤더 초기화
-    PUTTER(HDPT(bp), PACK(size, 0)); // 프리 블록 헤더
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp))); // 프리 블록 헤더
     PUTTER(FTPT(bp), PACK(size, 0)); // 프리 블록 풋터
     PUTTER(HDPT(NEXT_BLKP(bp)), PACK(0, 1)); // 새로운 에필로그 헤더
 
@@ -103,34 +238,40 @@ static void* extend_heap(size_t words) {
 
 // coalesce
 static void* coalesce(void* bp) {
-    size_t prev_alloc = IS_ALLOCATED(FTPT(PREV_BLKP(bp))); // 이전 블록 할당 여부
+    size_t prev_alloc = IS_PREV_ALLOCATED(HDPT(bp)); // 이전 블록 할당 여부
     size_t next_alloc = IS_ALLOCATED(HDPT(NEXT_BLKP(bp))); // 다음 블록 할당 여부
     size_t size = GET_SIZE(HDPT(bp)); // 현재 블록 크기
 
     if (prev_alloc && next_alloc) { // 이전과 다음 블록 모두 할당된 경우
+        insert_block(bp, size); // 리스트에 추가
         return bp;
     }
 
     else if (prev_alloc && !next_alloc) { // 다음 블록만 프리 상태인 경우
+        remove_block(NEXT_BLKP(bp)); // 다음 블록 리스트에서 제거
         size += GET_SIZE(HDPT(NEXT_BLKP(bp))); // 다음 블록 크기 추가
-        PUTTER(HDPT(bp), PACK(size, 0)); // 현재 블록 헤더 갱신
+        PUTTER(HDPT(bp), PACK(size, 0) | PREV_ALLOC); // 현재 블록 헤더 갱신
         PUTTER(FTPT(bp), PACK(size, 0)); // 현재 블록 풋터 갱신
     }
 
     else if (!prev_alloc && next_alloc) { // 이전 블록만 프리 상태인 경우
+        remove_block(PREV_BLKP(bp)); // 이전 블록 리스트에서 제거
         size += GET_SIZE(HDPT(PREV_BLKP(bp))); // 이전 블록 크기 추가
         PUTTER(FTPT(bp), PACK(size, 0)); // 현재 블록 풋터 갱신
-        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0)); // 이전 블록 헤더 갱신
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC); // 이전 블록 헤더 갱신
         bp = PREV_BLKP(bp); // 블록 포인터 이전 블록으로 이동
     }
 
     else { // 이전과 다음 블록 모두 프리 상태인 경우
+        remove_block(PREV_BLKP(bp)); // 이전 블록 리스트에서 제거
+        remove_block(NEXT_BLKP(bp)); // 다음 블록 리스트에서 제거
         size += GET_SIZE(HDPT(PREV_BLKP(bp))) + GET_SIZE(HDPT(NEXT_BLKP(bp))); // 이전과 다음 블록 크기 추가
-        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0)); // 이전 블록 헤더 갱신
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC); // 이전 블록 헤더 갱신
         PUTTER(FTPT(NEXT_BLKP(bp)), PACK(size, 0)); // 다음 블록 풋터 갱신
         bp = PREV_BLKP(bp); // 블록 포인터 이전 블록으로 이동
     }
 
+    insert_block(bp, size); // 통합된 블록 리스트에 추가
     return bp; // 통합된 블록 반환
 }
 
@@ -145,16 +286,23 @@ void* mm_malloc(size_t size) {
     }
 
     // 할당할 프리블록 찾기
-    if (size <= DSIZE) { // 최소 블록 크기 이하로 요청 받은 경우 최소 크기 블록으로 할당
-        a_size = 2 * DSIZE;
-    }
-    else { // 요청보다 더 크게 할당
-        // 헤더와 풋터를 위한 size + DSIZE
-        a_size = ((size + DSIZE - 1 + DSIZE) / DSIZE) * DSIZE;
+    a_size = BLOCK_SIZE(size); // 최소 블록 이하 요청은 최소 블록, 나머지는 헤더를 더해 정렬 단위로
+
+    // 같은 크기 블록이 quick list 에 있으면 병합/탐색 없이 바로 (LIFO)
+    if (a_size <= QUICK_MAX && quick_list[a_size / DSIZE] != NULL) {
+        bp = quick_list[a_size / DSIZE];
+        quick_list[a_size / DSIZE] = QUICK_NEXT(bp);
+        quick_count--;
+        return bp;
     }
 
-    // 적절한 프리 블록 탐색
-    if ((bp = worst_fit(a_size)) != NULL) {
+    // 적절한 프리 블록 탐색, 못 찾으면 quick list 블록들을 병합하고 한 번 더
+    bp = best_fit(a_size);
+    if (bp == NULL && quick_count > 0) {
+        consolidate();
+        bp = best_fit(a_size);
+    }
+    if (bp != NULL) {
         place(bp, a_size);
         return bp;  // 프리 블록 적절한 것 발견했다면 return 후 종료
     }
@@ -167,64 +315,130 @@ void* mm_malloc(size_t size) {
     return bp;  // 성공하면 블록 시작 주소 리턴
 }
 
-// best_fit
+// best_fit : 작은 요청은 같은 크기 리스트부터 비트맵으로 처음 비어있지 않은 리스트의 맨 앞, 없거나 큰 요청이면 트리에서 lower bound
+// 리스트 블록은 모두 리스트 크기와 같으므로 맨 앞이 가장 작은 블록 (주소순 빌드면 그중 주소가 가장 작은 블록)
 static void* best_fit(size_t a_size) {
-    void* bp; // 블록 포인터
-    void* best_bp = NULL; // 최적 블록 포인터
-    size_t best_size = (size_t)-1; // 최적 크기를 최대 값으로 초기화
-
-    for (int i = 0; i < LISTLIMIT; i++) { // 각 리스트 탐색
-        for (bp = segregation_list[i]; bp != NULL; bp = SUCC_FREEPT(bp)) { // 각 블록 탐색
-            size_t size = GET_SIZE(HDPT(bp)); // 현재 블록 크기
-            if (a_size <= size && size < best_size) { // 요청 크기에 맞고 현재 최적 크기보다 작은 경우
-                best_size = size; // 최적 크기 갱신
-                best_bp = bp; // 최적 블록 포인터 갱신
-            }
+    unsigned long long map; // 요청 리스트 이상 비어있지 않은 리스트들
+
+    if (a_size < TREE_MIN) {
+        map = list_bitmap & ~(CLASS_BIT(list_index(a_size)) - 1);
+        if (map != 0) {
+            return segregation_list[__builtin_ctzll(map)];
         }
     }
-    return best_bp; // 최적 블록 포인터 반환
+    return tree_lower_bound(a_size); // 트리의 블록은 모두 리스트 블록보다 큼
 }
 
 // place
 static void place(void* bp, size_t a_size) {
     size_t csize = GET_SIZE(HDPT(bp)); // 현재 블록 크기
 
-    if ((csize - a_size) >= (2 * DSIZE)) { // 블록 분할 가능한 경우
-        PUTTER(HDPT(bp), PACK(a_size, 1)); // 블록 할당 헤더 설정
-        PUTTER(FTPT(bp), PACK(a_size, 1)); // 블록 할당 풋터 설정
+    remove_block(bp); // 할당할 블록이므로 리스트에서 제거
+
+    if ((csize - a_size) >= MIN_BLOCK) { // 블록 분할 가능한 경우
+        PUTTER(HDPT(bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(bp))); // 블록 할당 헤더 설정
         bp = NEXT_BLKP(bp); // 블록 포인터 이동
-        PUTTER(HDPT(bp), PACK(csize - a_size, 0)); // 분할된 프리 블록 헤더 설정
+        PUTTER(HDPT(bp), PACK(csize - a_size, 0) | PREV_ALLOC); // 분할된 프리 블록 헤더 설정
         PUTTER(FTPT(bp), PACK(csize - a_size, 0)); // 분할된 프리 블록 풋터 설정
         insert_block(bp, csize - a_size); // 프리 블록 리스트에 추가
     }
     else { // 블록 분할 불가능한 경우
-        PUTTER(HDPT(bp), PACK(csize, 1)); // 전체 블록 할당 헤더 설정
-        PUTTER(FTPT(bp), PACK(csize, 1)); // 전체 블록 할당 풋터 설정
+        PUTTER(HDPT(bp), PACK(csize, 1) | IS_PREV_ALLOCATED(HDPT(bp))); // 전체 블록 할당 헤더 설정
+        SET_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 할당 블록은 풋터 없이 다음 블록 헤더에 표시
     }
 }
 
-// mm_free
+// mm_free : 작은 블록은 할당 상태 그대로 quick list 에 넣고 병합은 미룸
 void mm_free(void* bp)
+{
+    size_t size = GET_SIZE(HDPT(bp)); // 블록 크기
+
+    if (size <= QUICK_MAX) {
+        QUICK_NEXT(bp) = quick_list[size / DSIZE];
+        quick_list[size / DSIZE] = bp;
+        if (++quick_count > QUICK_LIMIT) { // 너무 많이 모였으면 한꺼번에 병합
+            consolidate();
+        }
+        return;
+    }
+    free_block(bp);
+}
+
+// consolidate : quick list 블록을 전부 실제로 해제하고 병합
+static void consolidate(void) {
+    void* bp;
+
+    for (int i = 0; i < QUICK_LISTS; i++) {
+        while ((bp = quick_list[i]) != NULL) {
+            quick_list[i] = QUICK_NEXT(bp);
+            free_block(bp);
+        }
+    }
+    quick_count = 0;
+}
+
+// free_block : 프리 블록으로 바꾸고 이웃과 병합
+static void free_block(void* bp)
 {
     size_t size = GET_SIZE(HDPT(bp)); // 블록 해제를 위해 매개변수 받기
 
-    PUTTER(HDPT(bp), PACK(size, 0)); // 프리블록으로 상태 변경
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp))); // 프리블록으로 상태 변경
     PUTTER(FTPT(bp), PACK(size, 0));
+    CLR_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 다음 블록에 이전 블록 프리 표시
     coalesce(bp); // 프리 블록 병합
 }
 
-// mm_realloc
+// mm_realloc : 뒤 블록이 프리거나 힙 끝이면 제자리에서 늘리고, 줄일 때는 뒷부분을 돌려줌
 void* mm_realloc(void* bp, size_t size)
 {
     void* old_bp = bp; // 기존 블록 포인터
     void* new_bp;  // 새로 할당되는 블록 할당 포인터
     size_t copySize; // 복사 데이터 크기
+    size_t a_size; // 새로 필요한 블록 크기
+    size_t c_size = GET_SIZE(HDPT(old_bp)); // 기존 블록 크기
+    size_t n_size = c_size; // 제자리에서 쓸 수 있는 크기
+    void* next_bp = NEXT_BLKP(old_bp); // 다음 블록
+
+    a_size = BLOCK_SIZE(size); // mm_malloc 과 같은 방식으로 블록 크기 계산
+
+    // 다음 블록이 프리면 합쳐서 쓸 수 있음
+    if (!IS_ALLOCATED(HDPT(next_bp))) {
+        n_size += GET_SIZE(HDPT(next_bp));
+    }
+    // 그래도 모자라는데 힙의 마지막 블록이면 모자란 만큼만 힙 확장
+    if (n_size < a_size && GET_SIZE(HDPT((char*)old_bp + n_size)) == 0
+#ifdef ADDRESS_ORDERED
+        && region_reserve(a_size - n_size) == 0
+#endif
+        && (long)mem_sbrk(a_size - n_size) != -1) {
+        n_size = a_size;
+        PUTTER(HDPT((char*)old_bp + n_size), PACK(0, 1)); // 새 에필로그 헤더
+    }
+
+    if (n_size >= a_size) { // 제자리에서 늘리거나 줄이기
+        if (n_size != c_size && !IS_ALLOCATED(HDPT(next_bp))) { // 합칠 다음 블록은 프리 리스트에서 제거
+            remove_block(next_bp);
+        }
+        if ((n_size - a_size) >= MIN_BLOCK) { // 남는 부분이 최소 블록 이상이면 떼어서 프리 블록으로
+            PUTTER(HDPT(old_bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(old_bp)));
+            next_bp = NEXT_BLKP(old_bp);
+            PUTTER(HDPT(next_bp), PACK(n_size - a_size, 0) | PREV_ALLOC);
+            PUTTER(FTPT(next_bp), PACK(n_size - a_size, 0));
+            CLR_PREV_ALLOC(HDPT(NEXT_BLKP(next_bp)));
+            coalesce(next_bp); // 그 뒤 블록이 프리면 합쳐짐
+        }
+        else {
+            PUTTER(HDPT(old_bp), PACK(n_size, 1) | IS_PREV_ALLOCATED(HDPT(old_bp)));
+            SET_PREV_ALLOC(HDPT(NEXT_BLKP(old_bp)));
+        }
+        return old_bp;
+    }
 
     new_bp = mm_malloc(size); // 새 블록 할당
 
     if (new_bp == NULL) return NULL;
 
-    copySize = GET_SIZE(HDPT(old_bp)); // 기존 블록 크기
+    copySize = c_size - WSIZE; // 기존 블록 페이로드 크기
 
     if (size < copySize) // 재할당할 크기가 기존보다 작으면
         copySize = size; // 원래 size만큼조정
@@ -237,69 +451,628 @@ void* mm_realloc(void* bp, size_t size)
     return new_bp; // 실패시 블록 할당 역할
 }
 
-// remove_block
-static void remove_block(void* bp) {
-    int i = 0; // 리스트 인덱스
-    size_t size = GET_SIZE(HDPT(bp)); // 블록 크기
+// mm_malloc_batch : 같은 크기 블록 n 개를 out 에 (돌려준 개수가 n 보다 작으면 메모리 부족)
+// 크기 계산은 한 번, 남은 개수가 모두 들어가는 프리 블록 하나를 찾아 앞에서부터 연달아 잘라 줌
+size_t mm_malloc_batch(size_t size, size_t n, void** out)
+{
+    size_t a_size; // 블록 하나 크기
+    size_t got = 0; // 할당한 개수
+    size_t k; // 이번 프리 블록에서 자를 개수
+    void* bp; // 잘라 쓸 프리 블록
+
+    if (size == 0 || n == 0) {
+        return 0;
+    }
+    a_size = BLOCK_SIZE(size);
 
-    while ((i < LISTLIMIT - 1) && (size > 1)) { // 적절한 리스트 인덱스 찾기
-        size >>= 1;
+    // 같은 크기 블록이 quick list 에 있으면 먼저
+    if (a_size <= QUICK_MAX) {
+        while (got < n && quick_list[a_size / DSIZE] != NULL) {
+            out[got] = quick_list[a_size / DSIZE];
+            quick_list[a_size / DSIZE] = QUICK_NEXT(out[got]);
+            quick_count--;
+            got++;
+        }
+    }
+
+    while (got < n) {
+        k = n - got;
+        // 남은 개수가 모두 들어가는 블록, 없으면 (힙 확장도 실패하면) 블록 하나 크기 이상 블록에서 들어가는 만큼
+        if (k > (size_t)-1 / a_size || (bp = batch_block(k * a_size)) == NULL) {
+            if ((bp = batch_block(a_size)) == NULL) {
+                break;
+            }
+            k = MIN(k, GET_SIZE(HDPT(bp)) / a_size);
+        }
+        place_batch(bp, k, a_size, NULL, out + got);
+        got += k;
+    }
+    return got;
+}
+
+// mm_malloc_multi : 크기가 다른 n 개 블록을 한 프리 블록에서 이어서 할당 (각각 따로 mm_free 가능)
+// 성공하면 0, 한 번에 들어가는 블록이 없으면 아무것도 할당하지 않고 -1
+int mm_malloc_multi(size_t n, const size_t* sizes, void** out)
+{
+    size_t total = 0; // 블록 크기 합
+    void* bp; // 잘라 쓸 프리 블록
+
+    if (n == 0) {
+        return 0;
+    }
+    for (size_t j = 0; j < n; j++) {
+        if (sizes[j] == 0 || BLOCK_SIZE(sizes[j]) > (size_t)-1 - total) {
+            return -1;
+        }
+        total += BLOCK_SIZE(sizes[j]);
+    }
+    if ((bp = batch_block(total)) == NULL) {
+        return -1;
+    }
+    place_batch(bp, n, 0, sizes, out);
+    return 0;
+}
+
+// mm_free_batch : 주소순으로 정렬해서 바로 이어진 블록들은 한 블록으로 묶어 한 번만 병합 (ptrs 는 정렬된 채로 남음)
+// quick list 를 거치지 않고 바로 프리 리스트로
+void mm_free_batch(void** ptrs, size_t n)
+{
+    char* bp; // 묶음 첫 블록
+    size_t size; // 묶음 크기
+    size_t i = 0;
+
+    qsort(ptrs, n, sizeof(void*), ptr_cmp);
+    while (i < n && ptrs[i] == NULL) { // NULL 은 정렬하면 맨 앞
         i++;
     }
+    while (i < n) {
+        bp = ptrs[i];
+        size = GET_SIZE(HDPT(bp));
+        while (++i < n && (char*)ptrs[i] == bp + size) { // 바로 뒤 블록도 해제 대상이면 묶기
+            size += GET_SIZE(HDPT(ptrs[i]));
+        }
+        PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp))); // 묶음 전체를 프리 블록 하나로
+        PUTTER(FTPT(bp), PACK(size, 0));
+        CLR_PREV_ALLOC(HDPT(NEXT_BLKP(bp)));
+        coalesce(bp); // 앞뒤 이웃과 병합은 묶음마다 한 번
+    }
+}
+
+// batch_block : total 바이트 이상 프리 블록 (quick list 병합 후 다시, 그래도 없으면 힙 확장)
+static void* batch_block(size_t total) {
+    void* bp = best_fit(total);
+
+    if (bp == NULL && quick_count > 0) {
+        consolidate();
+        bp = best_fit(total);
+    }
+    if (bp == NULL && total <= (size_t)INT_MAX - CHUNKSIZE) { // mem_sbrk 는 int 크기까지
+        bp = extend_heap(MAX(total, CHUNKSIZE) / WSIZE);
+    }
+    return bp;
+}
+
+// place_batch : 프리 블록 bp 앞에서부터 k 개 블록을 연달아 할당 (sizes 가 NULL 이면 모두 a_size)
+// 남는 부분이 최소 블록 이상이면 프리 블록으로, 아니면 마지막 블록에 붙임
+static void place_batch(void* bp, size_t k, size_t a_size, const size_t* sizes, void** out) {
+    size_t c_size = GET_SIZE(HDPT(bp)); // 남은 크기
+    size_t prev = IS_PREV_ALLOCATED(HDPT(bp)); // 첫 블록의 이전 블록 할당 비트
+    size_t size = 0; // 마지막으로 자른 블록 크기
+    char* p = bp; // 자를 자리
+
+    remove_block(bp); // 할당할 블록이므로 리스트에서 제거
+
+    for (size_t j = 0; j < k; j++) {
+        size = (sizes != NULL) ? BLOCK_SIZE(sizes[j]) : a_size;
+        PUTTER(HDPT(p), PACK(size, 1) | prev); // 할당 블록 헤더 (풋터 없음)
+        out[j] = p;
+        prev = PREV_ALLOC;
+        c_size -= size;
+        p += size;
+    }
+
+    if (c_size >= MIN_BLOCK) { // 남는 부분은 프리 블록으로 (뒤 블록은 원래 할당 상태이므로 병합 없음)
+        PUTTER(HDPT(p), PACK(c_size, 0) | PREV_ALLOC);
+        PUTTER(FTPT(p), PACK(c_size, 0));
+        insert_block(p, c_size);
+    }
+    else { // 최소 블록보다 작으면 마지막 블록에 붙이기
+        p -= size;
+        PUTTER(HDPT(p), PACK(size + c_size, 1) | (GETTER(HDPT(p)) & PREV_ALLOC));
+        SET_PREV_ALLOC(HDPT(NEXT_BLKP(p)));
+    }
+}
+
+// ptr_cmp : 주소 오름차순
+static int ptr_cmp(const void* a, const void* b) {
+    char* x = *(char* const*)a;
+    char* y = *(char* const*)b;
+
+    return (x > y) - (x < y);
+}
+
+// mm_memalign : alignment (2의 거듭제곱) 배수 주소의 페이로드
+// 정렬된 페이로드가 들어가는 프리 블록을 찾아 앞 조각은 프리 블록으로 떼어 내고, 뒷부분은 place 가 분할
+void* mm_memalign(size_t alignment, size_t size)
+{
+    size_t a_size; // 실제로 할당할 블록 크기
+    size_t extend_size; // 힙을 확장할 크기
+    char* bp; // 정렬된 페이로드를 담을 프리 블록
+
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) { // 2의 거듭제곱만
+        errno = EINVAL;
+        return NULL;
+    }
+    if (alignment <= ALIGNMENT) { // 기본 정렬로 충분
+        return mm_malloc(size);
+    }
+    if (size == 0) {
+        return NULL;
+    }
+
+    a_size = BLOCK_SIZE(size); // mm_malloc 과 같은 방식으로 블록 크기 계산
+
+    // 정렬된 페이로드가 들어가는 프리 블록 탐색, 못 찾으면 quick list 블록들을 병합하고 한 번 더
+    bp = aligned_fit(alignment, a_size);
+    if (bp == NULL && quick_count > 0) {
+        consolidate();
+        bp = aligned_fit(alignment, a_size);
+    }
+    if (bp == NULL) { // 어느 주소에서 시작해도 정렬된 페이로드가 들어가는 크기로 힙 확장
+        extend_size = MAX(a_size + alignment + MIN_BLOCK, CHUNKSIZE);
+        if ((bp = extend_heap(extend_size / WSIZE)) == NULL) {
+            return NULL;
+        }
+    }
+    return place_aligned(bp, alignment, a_size);
+}
+
+// mm_aligned_alloc : C11 aligned_alloc 과 같은 모양
+void* mm_aligned_alloc(size_t alignment, size_t size)
+{
+    return mm_memalign(alignment, size);
+}
+
+// aligned_fit : 정렬된 페이로드 + a_size 가 들어가는 프리 블록
+// 리스트는 요청 리스트부터 위 리스트들까지 크기순으로, 트리는 a_size 이상 가장 작은 블록이 안 맞으면
+// 어느 주소에서 시작해도 들어가는 크기 (a_size + alignment + 최소 블록) 이상 가장 작은 블록
+static void* aligned_fit(size_t alignment, size_t a_size) {
+    void* bp; // 블록 포인터
+    unsigned long long map; // 요청 리스트 이상 비어있지 않은 리스트들
+
+    if (a_size < TREE_MIN) {
+        for (map = list_bitmap & ~(CLASS_BIT(list_index(a_size)) - 1); map != 0; map &= map - 1) {
+            for (bp = segregation_list[__builtin_ctzll(map)]; bp != NULL; bp = SUCC_FREEPT(bp)) {
+                if (aligned_payload(bp, alignment) + a_size <= (char*)bp + GET_SIZE(HDPT(bp))) {
+                    return bp;
+                }
+            }
+        }
+    }
+    bp = tree_lower_bound(a_size);
+    if (bp != NULL && aligned_payload(bp, alignment) + a_size <= (char*)bp + GET_SIZE(HDPT(bp))) {
+        return bp;
+    }
+    return tree_lower_bound(a_size + alignment + MIN_BLOCK);
+}
+
+// aligned_payload : 프리 블록 bp 안에서 처음으로 정렬되는 페이로드 주소 (앞 조각은 없거나 최소 블록 이상)
+static char* aligned_payload(void* bp, size_t alignment) {
+    char* p = (char*)(((uintptr_t)bp + alignment - 1) & ~(uintptr_t)(alignment - 1));
+
+    if (p != (char*)bp && p - (char*)bp < MIN_BLOCK) { // 앞 조각이 최소 블록보다 작으면 다음 정렬 주소
+        p += alignment;
+    }
+    return p;
+}
+
+// place_aligned : 정렬된 자리 앞 조각을 프리 블록으로 떼어 내고 정렬된 자리에서 place
+static void* place_aligned(void* bp, size_t alignment, size_t a_size) {
+    char* p = aligned_payload(bp, alignment); // 정렬된 페이로드
+    size_t c_size = GET_SIZE(HDPT(bp)); // 현재 블록 크기
+    size_t lead = p - (char*)bp; // 앞 조각 크기
+
+    if (lead > 0) {
+        remove_block(bp);
+        // 앞 조각 : 프리 블록의 앞 블록은 항상 할당 상태이므로 병합할 것 없음
+        PUTTER(HDPT(bp), PACK(lead, 0) | IS_PREV_ALLOCATED(HDPT(bp)));
+        PUTTER(FTPT(bp), PACK(lead, 0));
+        insert_block(bp, lead);
+        // 정렬된 자리부터 나머지 (앞 블록은 프리)
+        PUTTER(HDPT(p), PACK(c_size - lead, 0));
+        PUTTER(FTPT(p), PACK(c_size - lead, 0));
+        insert_block(p, c_size - lead);
+    }
+    place(p, a_size); // 뒷부분은 최소 블록 이상이면 분할
+    return p;
+}
+
+// list_index : 블록 크기에 맞는 분리 리스트 번호 (TREE_MIN 보다 작은 블록만, 크기마다 리스트 하나)
+static int list_index(size_t size) {
+    return (int)(size / ALIGNMENT);
+}
+
+// remove_block
+static void remove_block(void* bp) {
+    int i = list_index(GET_SIZE(HDPT(bp))); // 리스트 인덱스
 
+    if (GET_SIZE(HDPT(bp)) >= TREE_MIN) { // 큰 블록은 트리에서
+        tree_remove(bp);
+        return;
+    }
+#ifdef ADDRESS_ORDERED
+    if (REGION_FIRST(REGION_OF(bp), i) == bp) { // 칸의 첫 블록이면 주소순 다음 블록이 같은 칸일 때만 물려줌
+        void* next = SUCC_FREEPT(bp);
+        REGION_FIRST(REGION_OF(bp), i) = (next != NULL && REGION_OF(next) == REGION_OF(bp)) ? next : NULL;
+        region_mark(REGION_OF(bp), i);
+    }
+#endif
     if (SUCC_FREEPT(bp) != NULL) { // 다음 블록이 존재하는 경우
-        PRED_FREEPT(SUCC_FREEPT(bp)) = PRED_FREEPT(bp); // 이전 블록 연결 갱신
+        SET_PRED_FREEPT(SUCC_FREEPT(bp), PRED_FREEPT(bp)); // 이전 블록 연결 갱신
     }
     if (PRED_FREEPT(bp) != NULL) { // 이전 블록이 존재하는 경우
-        SUCC_FREEPT(PRED_FREEPT(bp)) = SUCC_FREEPT(bp); // 다음 블록 연결 갱신
+        SET_SUCC_FREEPT(PRED_FREEPT(bp), SUCC_FREEPT(bp)); // 다음 블록 연결 갱신
     }
     else { // 현재 블록이 리스트의 첫 블록인 경우
         segregation_list[i] = SUCC_FREEPT(bp); // 리스트 헤더 갱신
+        if (segregation_list[i] == NULL) { // 리스트가 비면 비트맵에서 지우기
+            list_bitmap &= ~CLASS_BIT(i);
+        }
     }
 }
 
 
-// insert_block
+// insert_block : 리스트 맨 앞에 (주소순 빌드면 주소순 자리에)
 static void insert_block(void* bp, size_t size) {
-    int i = 0; // 리스트 인덱스
-    void* search_bp = NULL; // 검색 블록 포인터
-    void* insert_bp = NULL; // 삽입 위치 블록 포인터
+    int i; // 리스트 인덱스
+    void* insert_bp = NULL; // 바로 앞 블록 (NULL 이면 맨 앞)
+    void* search_bp; // 바로 뒤 블록
 
-    while ((i < LISTLIMIT - 1) && (size > 1)) { // 적절한 리스트 인덱스 찾기
-        size >>= 1;
-        i++;
+    if (size >= TREE_MIN) { // 큰 블록은 트리로
+        tree_insert(bp);
+        return;
+    }
+    i = list_index(size);
+    list_bitmap |= CLASS_BIT(i); // 비어있지 않은 리스트로 표시
+#ifdef ADDRESS_ORDERED
+    insert_bp = region_pred(i, bp); // 주소순으로 바로 앞 블록 (없으면 맨 앞에)
+    if (REGION_FIRST(REGION_OF(bp), i) == NULL || (char*)bp < (char*)REGION_FIRST(REGION_OF(bp), i)) { // 칸의 첫 블록 갱신
+        REGION_FIRST(REGION_OF(bp), i) = bp;
+        region_mark(REGION_OF(bp), i);
+    }
+#endif
+    search_bp = (insert_bp != NULL) ? SUCC_FREEPT(insert_bp) : segregation_list[i];
+
+    SET_SUCC_FREEPT(bp, search_bp);
+    SET_PRED_FREEPT(bp, insert_bp);
+    if (search_bp != NULL) {
+        SET_PRED_FREEPT(search_bp, bp);
     }
+    if (insert_bp != NULL) {
+        SET_SUCC_FREEPT(insert_bp, bp);
+    }
+    else {
+        segregation_list[i] = bp;
+    }
+}
 
-    search_bp = segregation_list[i]; // 리스트 헤더로부터 검색 시작
-    while ((search_bp != NULL) && (size > GET_SIZE(HDPT(search_bp)))) { // 적절한 위치 찾기
-        insert_bp = search_bp;
-        search_bp = SUCC_FREEPT(search_bp);
+/////// 큰 프리 블록 트리
+
+// tree_insert : bp 를 (크기, 주소) 자리에 넣고 red-black 성질 복구
+static void tree_insert(void* bp) {
+    void* y = TREE_NIL; // 넣을 자리의 부모
+    void* x = tree_root;
+    void* u; // 삼촌
+
+    while (x != TREE_NIL) {
+        y = x;
+        x = TREE_LESS(bp, x) ? TREE_LEFT(x) : TREE_RIGHT(x);
+    }
+    SET_TREE_PARENT(bp, y);
+    if (y == TREE_NIL) {
+        tree_root = bp;
+    }
+    else if (TREE_LESS(bp, y)) {
+        SET_TREE_LEFT(y, bp);
     }
+    else {
+        SET_TREE_RIGHT(y, bp);
+    }
+    SET_TREE_LEFT(bp, TREE_NIL);
+    SET_TREE_RIGHT(bp, TREE_NIL);
+    TREE_COLOR(bp) = RED;
 
-    if (search_bp != NULL) { // 삽입 위치가 리스트 중간인 경우
-        if (insert_bp != NULL) { // 삽입 위치가 리스트 중간인 경우
-            SUCC_FREEPT(insert_bp) = bp;
-            PRED_FREEPT(search_bp) = bp;
-            SUCC_FREEPT(bp) = search_bp;
-            PRED_FREEPT(bp) = insert_bp;
+    // 빨간 노드가 연속이면 색 바꾸기 / 회전
+    while (TREE_COLOR(TREE_PARENT(bp)) == RED) {
+        void* p = TREE_PARENT(bp);
+        void* g = TREE_PARENT(p);
+        if (p == TREE_LEFT(g)) {
+            u = TREE_RIGHT(g);
+            if (TREE_COLOR(u) == RED) {
+                TREE_COLOR(p) = BLACK;
+                TREE_COLOR(u) = BLACK;
+                TREE_COLOR(g) = RED;
+                bp = g;
+                continue;
+            }
+            if (bp == TREE_RIGHT(p)) {
+                bp = p;
+                tree_rotate_left(bp);
+                p = TREE_PARENT(bp);
+            }
+            TREE_COLOR(p) = BLACK;
+            TREE_COLOR(g) = RED;
+            tree_rotate_right(g);
         }
-        else { // 삽입 위치가 리스트의 첫 블록인 경우
-            SUCC_FREEPT(bp) = search_bp;
-            PRED_FREEPT(search_bp) = bp;
-            PRED_FREEPT(bp) = NULL;
-            segregation_list[i] = bp;
+        else {
+            u = TREE_LEFT(g);
+            if (TREE_COLOR(u) == RED) {
+                TREE_COLOR(p) = BLACK;
+                TREE_COLOR(u) = BLACK;
+                TREE_COLOR(g) = RED;
+                bp = g;
+                continue;
+            }
+            if (bp == TREE_LEFT(p)) {
+                bp = p;
+                tree_rotate_right(bp);
+                p = TREE_PARENT(bp);
+            }
+            TREE_COLOR(p) = BLACK;
+            TREE_COLOR(g) = RED;
+            tree_rotate_left(g);
         }
     }
-    else { // 삽입 위치가 리스트의 끝인 경우
-        if (insert_bp != NULL) { // 삽입 위치가 리스트 중간인 경우
-            SUCC_FREEPT(insert_bp) = bp;
-            PRED_FREEPT(bp) = insert_bp;
-            SUCC_FREEPT(bp) = NULL;
+    TREE_COLOR(tree_root) = BLACK;
+}
+
+// tree_remove : bp 를 트리에서 빼고 red-black 성질 복구
+static void tree_remove(void* bp) {
+    void* y = bp; // 실제로 빠지는 노드
+    void* x; // y 자리에 올라오는 노드
+    void* w; // x 의 형제
+    unsigned int y_color = TREE_COLOR(y);
+
+    if (TREE_LEFT(bp) == TREE_NIL) {
+        x = TREE_RIGHT(bp);
+        tree_transplant(bp, x);
+    }
+    else if (TREE_RIGHT(bp) == TREE_NIL) {
+        x = TREE_LEFT(bp);
+        tree_transplant(bp, x);
+    }
+    else { // 자식이 둘이면 오른쪽 서브트리의 가장 작은 노드로 대체
+        for (y = TREE_RIGHT(bp); TREE_LEFT(y) != TREE_NIL; y = TREE_LEFT(y))
+            ;
+        y_color = TREE_COLOR(y);
+        x = TREE_RIGHT(y);
+        if (TREE_PARENT(y) == bp) {
+            SET_TREE_PARENT(x, y);
         }
-        else { // 삽입 위치가 리스트의 첫 블록인 경우
-            SUCC_FREEPT(bp) = NULL;
-            PRED_FREEPT(bp) = NULL;
-            segregation_list[i] = bp;
+        else {
+            tree_transplant(y, x);
+            SET_TREE_RIGHT(y, TREE_RIGHT(bp));
+            SET_TREE_PARENT(TREE_RIGHT(y), y);
+        }
+        tree_transplant(bp, y);
+        SET_TREE_LEFT(y, TREE_LEFT(bp));
+        SET_TREE_PARENT(TREE_LEFT(y), y);
+        TREE_COLOR(y) = TREE_COLOR(bp);
+    }
+
+    if (y_color == RED) {
+        return;
+    }
+    // 검은 노드가 빠졌으면 x 쪽 검은 높이 복구
+    while (x != tree_root && TREE_COLOR(x) == BLACK) {
+        void* p = TREE_PARENT(x);
+        if (x == TREE_LEFT(p)) {
+            w = TREE_RIGHT(p);
+            if (TREE_COLOR(w) == RED) {
+                TREE_COLOR(w) = BLACK;
+                TREE_COLOR(p) = RED;
+                tree_rotate_left(p);
+                w = TREE_RIGHT(p);
+            }
+            if (TREE_COLOR(TREE_LEFT(w)) == BLACK && TREE_COLOR(TREE_RIGHT(w)) == BLACK) {
+                TREE_COLOR(w) = RED;
+                x = p;
+                continue;
+            }
+            if (TREE_COLOR(TREE_RIGHT(w)) == BLACK) {
+                TREE_COLOR(TREE_LEFT(w)) = BLACK;
+                TREE_COLOR(w) = RED;
+                tree_rotate_right(w);
+                w = TREE_RIGHT(p);
+            }
+            TREE_COLOR(w) = TREE_COLOR(p);
+            TREE_COLOR(p) = BLACK;
+            TREE_COLOR(TREE_RIGHT(w)) = BLACK;
+            tree_rotate_left(p);
         }
+        else {
+            w = TREE_LEFT(p);
+            if (TREE_COLOR(w) == RED) {
+                TREE_COLOR(w) = BLACK;
+                TREE_COLOR(p) = RED;
+                tree_rotate_right(p);
+                w = TREE_LEFT(p);
+            }
+            if (TREE_COLOR(TREE_LEFT(w)) == BLACK && TREE_COLOR(TREE_RIGHT(w)) == BLACK) {
+                TREE_COLOR(w) = RED;
+                x = p;
+                continue;
+            }
+            if (TREE_COLOR(TREE_LEFT(w)) == BLACK) {
+                TREE_COLOR(TREE_RIGHT(w)) = BLACK;
+                TREE_COLOR(w) = RED;
+                tree_rotate_left(w);
+                w = TREE_LEFT(p);
+            }
+            TREE_COLOR(w) = TREE_COLOR(p);
+            TREE_COLOR(p) = BLACK;
+            TREE_COLOR(TREE_LEFT(w)) = BLACK;
+            tree_rotate_right(p);
+        }
+        x = tree_root;
+    }
+    TREE_COLOR(x) = BLACK;
+}
+
+// tree_lower_bound : 크기가 a_size 이상인 블록 중 (크기, 주소)가 가장 작은 블록, O(log n)
+static void* tree_lower_bound(size_t a_size) {
+    void* x = tree_root;
+    void* best = NULL;
+
+    while (x != TREE_NIL) {
+        if (GET_SIZE(HDPT(x)) >= a_size) { // 맞는 블록이면 기억하고 더 작은 쪽으로
+            best = x;
+            x = TREE_LEFT(x);
+        }
+        else {
+            x = TREE_RIGHT(x);
+        }
+    }
+    return best;
+}
+
+// tree_rotate_left : x 의 오른쪽 자식을 x 자리로
+static void tree_rotate_left(void* x) {
+    void* y = TREE_RIGHT(x);
+
+    SET_TREE_RIGHT(x, TREE_LEFT(y));
+    if (TREE_LEFT(y) != TREE_NIL) {
+        SET_TREE_PARENT(TREE_LEFT(y), x);
+    }
+    tree_transplant(x, y);
+    SET_TREE_LEFT(y, x);
+    SET_TREE_PARENT(x, y);
+}
+
+// tree_rotate_right : x 의 왼쪽 자식을 x 자리로
+static void tree_rotate_right(void* x) {
+    void* y = TREE_LEFT(x);
+
+    SET_TREE_LEFT(x, TREE_RIGHT(y));
+    if (TREE_RIGHT(y) != TREE_NIL) {
+        SET_TREE_PARENT(TREE_RIGHT(y), x);
+    }
+    tree_transplant(x, y);
+    SET_TREE_RIGHT(y, x);
+    SET_TREE_PARENT(x, y);
+}
+
+// tree_transplant : u 자리에 v 를 붙임 (u 의 부모 쪽 연결만 바꿈)
+static void tree_transplant(void* u, void* v) {
+    if (TREE_PARENT(u) == TREE_NIL) {
+        tree_root = v;
+    }
+    else if (u == TREE_LEFT(TREE_PARENT(u))) {
+        SET_TREE_LEFT(TREE_PARENT(u), v);
+    }
+    else {
+        SET_TREE_RIGHT(TREE_PARENT(u), v);
+    }
+    SET_TREE_PARENT(v, TREE_PARENT(u));
+}
+
+#ifdef ADDRESS_ORDERED
+/////// 주소순 리스트 인덱스
+
+// region_reserve : 힙이 incr 만큼 늘어도 모든 칸이 인덱스 배열에 들어가도록 미리 늘림 (비트맵도 같이)
+// 배열 하나만 늘고 실패하면 그 배열은 커진 채로 두고 칸 수는 그대로 (다음에 다시 늘림)
+static int region_reserve(size_t incr) {
+    size_t need = ((mem_heapsize() + incr) >> REGION_SHIFT) + 1; // 필요한 칸 수
+    size_t cap = (region_cap != 0) ? region_cap : REGION_MIN; // 새 칸 수
+    size_t bits = LISTLIMIT * sizeof(unsigned long long); // 비트맵 워드 한 줄 (클래스 수만큼)
+    void* p;
+    void* b;
+    void* q;
+
+    if (need <= region_cap) {
+        return 0;
+    }
+    while (cap < need) {
+        cap *= 2;
+    }
+    if (region_first == NULL) { // 익명 매핑이라 0 (빈 칸) 으로 시작
+        p = mmap(NULL, cap * LISTLIMIT * sizeof(void*), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        b = mmap(NULL, (cap >> 6) * bits, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        q = mmap(NULL, ((cap >> 12) + 1) * bits, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    else { // 늘어난 부분도 0 (칸이 바깥 인덱스라 뒤에 붙기만 함)
+        p = mremap(region_first, region_cap * LISTLIMIT * sizeof(void*), cap * LISTLIMIT * sizeof(void*), MREMAP_MAYMOVE);
+        b = mremap(region_bits, (region_cap >> 6) * bits, (cap >> 6) * bits, MREMAP_MAYMOVE);
+        q = mremap(region_sum, ((region_cap >> 12) + 1) * bits, ((cap >> 12) + 1) * bits, MREMAP_MAYMOVE);
+    }
+    if (p != MAP_FAILED) {
+        region_first = p;
+    }
+    if (b != MAP_FAILED) {
+        region_bits = b;
+    }
+    if (q != MAP_FAILED) {
+        region_sum = q;
+    }
+    if (p == MAP_FAILED || b == MAP_FAILED || q == MAP_FAILED) {
+        return -1;
+    }
+    region_cap = cap;
+    return 0;
+}
+
+// region_mark : r 칸 i 클래스에 첫 블록이 생겼거나 없어졌으면 비트맵에 반영
+static void region_mark(size_t r, int i) {
+    if (REGION_FIRST(r, i) != NULL) {
+        REGION_BITS(r >> 6, i) |= BIT(r);
+        REGION_SUM(r >> 12, i) |= BIT(r >> 6);
+    }
+    else {
+        REGION_BITS(r >> 6, i) &= ~BIT(r);
+        if (REGION_BITS(r >> 6, i) == 0) { // 워드가 비었으면 요약에서도
+            REGION_SUM(r >> 12, i) &= ~BIT(r >> 6);
+        }
+    }
+}
+
+// region_before : i 클래스에서 r 칸보다 앞쪽으로 첫 블록이 있는 가장 가까운 칸 (없으면 -1)
+// 같은 워드 -> 같은 요약 워드 -> 앞 요약 워드들 (요약 워드 하나가 칸 4096 개) 순서로 clz
+static long region_before(size_t r, int i) {
+    size_t w = r >> 6; // REGION_BITS 워드
+    size_t v = r >> 12; // REGION_SUM 워드
+    unsigned long long m = REGION_BITS(w, i) & (BIT(r) - 1); // 같은 워드의 앞 칸들
+
+    if (m == 0) {
+        m = REGION_SUM(v, i) & (BIT(w) - 1); // 같은 요약 워드의 앞 워드들
+        while (m == 0) {
+            if (v == 0) {
+                return -1;
+            }
+            m = REGION_SUM(--v, i);
+        }
+        w = (v << 6) + 63 - __builtin_clzll(m);
+        m = REGION_BITS(w, i);
+    }
+    return (long)((w << 6) + 63 - __builtin_clzll(m));
+}
+
+// region_pred : i 클래스에서 bp 보다 주소가 작은 블록 중 가장 뒤 블록 (없으면 NULL)
+static void* region_pred(int i, void* bp) {
+    size_t r = REGION_OF(bp);
+    void* p = REGION_FIRST(r, i); // 걷기 시작할 블록
+
+    if (p == NULL || (char*)p > (char*)bp) { // 같은 칸에 앞 블록이 없으면 앞쪽으로 가장 가까운 칸
+        long q = region_before(r, i);
+
+        if (q < 0) {
+            return NULL;
+        }
+        p = REGION_FIRST(q, i);
+    }
+    // 그 칸 안에서 bp 바로 앞까지 (사이 칸들은 비어 있으므로 칸 하나만 걸음)
+    while (SUCC_FREEPT(p) != NULL && (char*)SUCC_FREEPT(p) < (char*)bp) {
+        p = SUCC_FREEPT(p);
     }
+    return p;
 }
+#endif
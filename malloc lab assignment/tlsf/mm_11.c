@@ -0,0 +1,383 @@
+// TLSF (Two-Level Segregated Fit) - good fit, O(1)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <sys/mman.h>
+#include <errno.h>
+
+#include "mm.h"
+#include "memlib.h"
+
+
+// 이미 있던 !
+#define ALIGNMENT 8
+#define ALIGN(size) (((size) + (ALIGNMENT-1)) & ~0x7)
+#define SIZE_T_SIZE (ALIGN(sizeof(size_t)))
+
+/////// 워드, 헤더, 푸터 / 더블 워드 / 힙 확장 기본 바이트
+#define WSIZE       4
+#define DSIZE       8
+#define CHUNKSIZE   (1 << 12)
+
+/////// 2단계 인덱스
+// 1단계(fl) : 2의 거듭제곱 구간, 2단계(sl) : 그 구간을 SL_COUNT 등분
+// SMALL_BLOCK 미만 블록은 fl = 0 에서 8바이트 간격으로 바로 나눔
+#define SL_LOG2     4                           // 2단계 리스트 수의 log2
+#define SL_COUNT    (1 << SL_LOG2)              // 1단계 구간당 2단계 리스트 수
+#define FL_SHIFT    (SL_LOG2 + 3)               // SMALL_BLOCK 의 log2 (8바이트 정렬 * SL_COUNT)
+#define SMALL_BLOCK (1 << FL_SHIFT)             // 128바이트
+#define FL_COUNT    (32 - FL_SHIFT + 1)         // 32비트 크기까지 1단계 리스트 수
+
+#define MAX(x, y)   ((x) > (y) ? (x) : (y))
+
+// 정보 (블록 사이즈와 할당 여부에 대한 정보를 헤더와 풋터에 넣어야 함)
+#define PACK(size, alloc)   ((size) | (alloc))
+
+#define GETTER(p)  (*(unsigned int *)(p))
+#define PUTTER(p, val)  (*(unsigned int *)(p) = (val))
+
+#define GET_SIZE(p)    (GETTER(p) & ~0x7)   // 블록 크기
+#define IS_ALLOCATED(p)   (GETTER(p) & 0x1)  // 블록 할당 여부
+#define IS_PREV_ALLOCATED(p)   (GETTER(p) & 0x2)   // 이전 블록 할당 여부 (헤더에만 기록)
+#define PREV_ALLOC  0x2   // 헤더의 이전 블록 할당 비트
+
+#define SET_PREV_ALLOC(p)   PUTTER(p, GETTER(p) | PREV_ALLOC)   // 이전 블록 할당 표시
+#define CLR_PREV_ALLOC(p)   PUTTER(p, GETTER(p) & ~PREV_ALLOC)  // 이전 블록 프리 표시
+
+#define HDPT(bp)    ((char *)(bp) - WSIZE)  // 헤더 포인터
+#define FTPT(bp)    ((char *)(bp) + GET_SIZE(HDPT(bp)) - DSIZE)  // 풋터 포인터
+
+#define NEXT_BLKP(bp)   (((char *)(bp) + GET_SIZE((char *)(bp) - WSIZE)))   // 다음 블록 포인터
+#define PREV_BLKP(bp)   (((char *)(bp) - GET_SIZE((char *)(bp) - DSIZE)))   // 이전 블록 포인터
+
+// 프리 블록 링크는 포인터 대신 heap_list 로부터의 오프셋 / DSIZE 를 한 워드에 (0 은 NULL)
+// 64비트에서도 최소 블록 16바이트 (헤더 + 이전 + 다음 + 풋터) 그대로, 대신 힙은 heap_list 부터 32GB (2^32 * DSIZE) 까지
+#define TO_LINK(p)      ((p) == NULL ? 0u : (unsigned int)(((char*)(p) - (char*)heap_list) / DSIZE))
+#define FROM_LINK(v)    ((v) == 0 ? NULL : (void*)((char*)heap_list + (size_t)(v) * DSIZE))
+
+#define PRED_FREEPT(bp) FROM_LINK(GETTER(bp)) // 이전 프리블록 포인터
+#define SUCC_FREEPT(bp) FROM_LINK(GETTER((char*)(bp) + WSIZE)) // 다음 프리블록 포인터
+#define SET_PRED_FREEPT(bp, p)  PUTTER(bp, TO_LINK(p))
+#define SET_SUCC_FREEPT(bp, p)  PUTTER((char*)(bp) + WSIZE, TO_LINK(p))
+
+static void* heap_list = NULL; // 힙 리스트 시작 포인터
+static void* free_lists[FL_COUNT][SL_COUNT]; // [fl][sl] 프리 리스트
+static unsigned int fl_bitmap; // 비어있지 않은 1단계 구간 비트맵
+static unsigned int sl_bitmap[FL_COUNT]; // 1단계 구간별 비어있지 않은 2단계 리스트 비트맵
+
+int mm_init(void);
+static void* extend_heap(size_t words);
+static void* coalesce(void* bp);
+void* mm_malloc(size_t size);
+static void* good_fit(size_t a_size);
+static void place(void* bp, size_t a_size);
+void mm_free(void* bp);
+void* mm_realloc(void* bp, size_t size);
+
+
+static void mapping(size_t size, int* fl, int* sl);
+static void remove_block(void* bp);
+static void insert_block(void* bp, size_t size);
+
+// mm_init
+int mm_init(void)
+{
+    for (int i = 0; i < FL_COUNT; i++) { // 2단계 리스트 비우기
+        for (int j = 0; j < SL_COUNT; j++) {
+            free_lists[i][j] = NULL;
+        }
+        sl_bitmap[i] = 0;
+    }
+    fl_bitmap = 0;
+
+    // 메모리 확장 실패
+    if ((heap_list = mem_sbrk(4 * WSIZE)) == (void*)-1) {
+        return -1;
+    }
+
+    PUTTER(heap_list, 0);                             // 시작 부분
+    PUTTER(heap_list + (1 * WSIZE), PACK(DSIZE, 1));  // 맨 앞 헤더 할당된 것
+    PUTTER(heap_list + (2 * WSIZE), PACK(DSIZE, 1));  // 풋터
+    PUTTER(heap_list + (3 * WSIZE), PACK(0, 1) | PREV_ALLOC);      // 뒷부분 헤더
+
+    heap_list += (2 * WSIZE); // 힙 리스트의 포인터를 맨 앞 블록의 끝으로
+
+    if (extend_heap(CHUNKSIZE / WSIZE) == NULL) // 확장 ~
+        return -1;
+
+    return 0;
+}
+
+// extend_heap
+static void* extend_heap(size_t words) {
+    char* bp; // 새로운 블록의 포인터
+    size_t size; // 요청된 크기
+
+    // 짝수 개의 단어로 크기 조정
+    size = (words % 2) ? (words + 1) * WSIZE : words * WSIZE;
+    if ((long)(bp = mem_sbrk(size)) == -1) // 메모리 할당 실패 시
+        return NULL;
+
+    // 프리 블록 헤더/풋터와 새로운 에필로그 헤더 초기화
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp))); // 프리 블록 헤더
+    PUTTER(FTPT(bp), PACK(size, 0)); // 프리 블록 풋터
+    PUTTER(HDPT(NEXT_BLKP(bp)), PACK(0, 1)); // 새로운 에필로그 헤더
+
+    // 이전 블록이 프리 상태라면 통합
+    return coalesce(bp); // 블록 통합 후 반환
+}
+
+// coalesce
+static void* coalesce(void* bp) {
+    size_t prev_alloc = IS_PREV_ALLOCATED(HDPT(bp)); // 이전 블록 할당 여부
+    size_t next_alloc = IS_ALLOCATED(HDPT(NEXT_BLKP(bp))); // 다음 블록 할당 여부
+    size_t size = GET_SIZE(HDPT(bp)); // 현재 블록 크기
+
+    if (prev_alloc && next_alloc) { // 이전과 다음 블록 모두 할당된 경우
+        insert_block(bp, size); // 리스트에 추가
+        return bp;
+    }
+
+    else if (prev_alloc && !next_alloc) { // 다음 블록만 프리 상태인 경우
+        remove_block(NEXT_BLKP(bp)); // 다음 블록 리스트에서 제거
+        size += GET_SIZE(HDPT(NEXT_BLKP(bp))); // 다음 블록 크기 추가
+        PUTTER(HDPT(bp), PACK(size, 0) | PREV_ALLOC); // 현재 블록 헤더 갱신
+        PUTTER(FTPT(bp), PACK(size, 0)); // 현재 블록 풋터 갱신
+    }
+
+    else if (!prev_alloc && next_alloc) { // 이전 블록만 프리 상태인 경우
+        remove_block(PREV_BLKP(bp)); // 이전 블록 리스트에서 제거
+        size += GET_SIZE(HDPT(PREV_BLKP(bp))); // 이전 블록 크기 추가
+        PUTTER(FTPT(bp), PACK(size, 0)); // 현재 블록 풋터 갱신
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC); // 이전 블록 헤더 갱신
+        bp = PREV_BLKP(bp); // 블록 포인터 이전 블록으로 이동
+    }
+
+    else { // 이전과 다음 블록 모두 프리 상태인 경우
+        remove_block(PREV_BLKP(bp)); // 이전 블록 리스트에서 제거
+        remove_block(NEXT_BLKP(bp)); // 다음 블록 리스트에서 제거
+        size += GET_SIZE(HDPT(PREV_BLKP(bp))) + GET_SIZE(HDPT(NEXT_BLKP(bp))); // 이전과 다음 블록 크기 추가
+        PUTTER(HDPT(PREV_BLKP(bp)), PACK(size, 0) | PREV_ALLOC); // 이전 블록 헤더 갱신
+        PUTTER(FTPT(NEXT_BLKP(bp)), PACK(size, 0)); // 다음 블록 풋터 갱신
+        bp = PREV_BLKP(bp); // 블록 포인터 이전 블록으로 이동
+    }
+
+    insert_block(bp, size); // 통합된 블록 리스트에 추가
+    return bp; // 통합된 블록 반환
+}
+
+// mm_malloc
+void* mm_malloc(size_t size) {
+    size_t a_size; // 실제로 할당할 블록 크기
+    size_t extend_size; // 힙을 확장할 크기
+    char* bp; // 찾은 프리 블록의 시작 주소
+
+    if (size == 0) { // 요청하는 크기가 0이면 할당 불필요
+        return NULL;
+    }
+
+    // 할당할 프리블록 찾기
+    if (size <= DSIZE + WSIZE) { // 최소 블록 크기 이하로 요청 받은 경우 최소 크기 블록으로 할당
+        a_size = 2 * DSIZE;
+    }
+    else { // 요청보다 더 크게 할당
+        // 할당 블록은 헤더만 있으므로 size + WSIZE
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
+    }
+
+    // 적절한 프리 블록 탐색 (비트맵 두 번으로 끝, 리스트 순회 없음)
+    if ((bp = good_fit(a_size)) != NULL) {
+        place(bp, a_size);
+        return bp;  // 프리 블록 적절한 것 발견했다면 return 후 종료
+    }
+    // 적절한 프리블록을 못 찾았다면
+    extend_size = MAX(a_size, CHUNKSIZE);  // 요청 크기와 기본 크기 중 큰 값으로 확장
+    if ((bp = extend_heap(extend_size / WSIZE)) == NULL) { // 정해진 크기로 힙 확장
+        return NULL; // 실패하면 -1 NULL
+    }
+    place(bp, a_size);  // bp 에는 함수를 통해 프리 블록 할당
+    return bp;  // 성공하면 블록 시작 주소 리턴
+}
+
+// good_fit : a_size 이상이 보장되는 가장 작은 리스트의 맨 앞 블록
+static void* good_fit(size_t a_size) {
+    int fl, sl; // 1단계, 2단계 인덱스
+    unsigned int map; // 후보 리스트 비트맵
+
+    // 요청 크기를 다음 2단계 경계로 올려서 찾은 리스트의 어떤 블록이든 맞도록
+    if (a_size >= SMALL_BLOCK) {
+        a_size += (1u << (31 - __builtin_clz((unsigned int)a_size) - SL_LOG2)) - 1;
+    }
+    mapping(a_size, &fl, &sl);
+    if (fl >= FL_COUNT) {
+        return NULL;
+    }
+
+    // 같은 1단계 구간에서 sl 이상인 비어있지 않은 리스트
+    map = sl_bitmap[fl] & (~0u << sl);
+    if (map == 0) {
+        // 없으면 더 큰 1단계 구간 중 비어있지 않은 첫 구간
+        map = fl_bitmap & (~0u << (fl + 1));
+        if (map == 0) {
+            return NULL; // 적합한 블록이 없을 경우 NULL 반환
+        }
+        fl = __builtin_ctz(map);
+        map = sl_bitmap[fl];
+    }
+    sl = __builtin_ctz(map);
+    return free_lists[fl][sl];
+}
+
+// place
+static void place(void* bp, size_t a_size) {
+    size_t csize = GET_SIZE(HDPT(bp)); // 현재 블록 크기
+
+    remove_block(bp); // 할당할 블록이므로 리스트에서 제거
+
+    if ((csize - a_size) >= (2 * DSIZE)) { // 블록 분할 가능한 경우
+        PUTTER(HDPT(bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(bp))); // 블록 할당 헤더 설정
+        bp = NEXT_BLKP(bp); // 블록 포인터 이동
+        PUTTER(HDPT(bp), PACK(csize - a_size, 0) | PREV_ALLOC); // 분할된 프리 블록 헤더 설정
+        PUTTER(FTPT(bp), PACK(csize - a_size, 0)); // 분할된 프리 블록 풋터 설정
+        insert_block(bp, csize - a_size); // 프리 블록 리스트에 추가
+    }
+    else { // 블록 분할 불가능한 경우
+        PUTTER(HDPT(bp), PACK(csize, 1) | IS_PREV_ALLOCATED(HDPT(bp))); // 전체 블록 할당 헤더 설정
+        SET_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 할당 블록은 풋터 없이 다음 블록 헤더에 표시
+    }
+}
+
+// mm_free
+void mm_free(void* bp)
+{
+    size_t size = GET_SIZE(HDPT(bp)); // 블록 해제를 위해 매개변수 받기
+
+    PUTTER(HDPT(bp), PACK(size, 0) | IS_PREV_ALLOCATED(HDPT(bp))); // 프리블록으로 상태 변경
+    PUTTER(FTPT(bp), PACK(size, 0));
+    CLR_PREV_ALLOC(HDPT(NEXT_BLKP(bp))); // 다음 블록에 이전 블록 프리 표시
+    coalesce(bp); // 프리 블록 병합
+}
+
+// mm_realloc : 뒤 블록이 프리거나 힙 끝이면 제자리에서 늘리고, 줄일 때는 뒷부분을 돌려줌
+void* mm_realloc(void* bp, size_t size)
+{
+    void* old_bp = bp; // 기존 블록 포인터
+    void* new_bp;  // 새로 할당되는 블록 할당 포인터
+    size_t copySize; // 복사 데이터 크기
+    size_t a_size; // 새로 필요한 블록 크기
+    size_t c_size = GET_SIZE(HDPT(old_bp)); // 기존 블록 크기
+    size_t n_size = c_size; // 제자리에서 쓸 수 있는 크기
+    void* next_bp = NEXT_BLKP(old_bp); // 다음 블록
+
+    if (size <= DSIZE + WSIZE) { // mm_malloc 과 같은 방식으로 블록 크기 계산
+        a_size = 2 * DSIZE;
+    }
+    else {
+        a_size = ((size + WSIZE + DSIZE - 1) / DSIZE) * DSIZE;
+    }
+
+    // 다음 블록이 프리면 합쳐서 쓸 수 있음
+    if (!IS_ALLOCATED(HDPT(next_bp))) {
+        n_size += GET_SIZE(HDPT(next_bp));
+    }
+    // 그래도 모자라는데 힙의 마지막 블록이면 모자란 만큼만 힙 확장
+    if (n_size < a_size && GET_SIZE(HDPT((char*)old_bp + n_size)) == 0
+        && (long)mem_sbrk(a_size - n_size) != -1) {
+        n_size = a_size;
+        PUTTER(HDPT((char*)old_bp + n_size), PACK(0, 1)); // 새 에필로그 헤더
+    }
+
+    if (n_size >= a_size) { // 제자리에서 늘리거나 줄이기
+        if (n_size != c_size && !IS_ALLOCATED(HDPT(next_bp))) { // 합칠 다음 블록은 프리 리스트에서 제거
+            remove_block(next_bp);
+        }
+        if ((n_size - a_size) >= (2 * DSIZE)) { // 남는 부분이 최소 블록 이상이면 떼어서 프리 블록으로
+            PUTTER(HDPT(old_bp), PACK(a_size, 1) | IS_PREV_ALLOCATED(HDPT(old_bp)));
+            next_bp = NEXT_BLKP(old_bp);
+            PUTTER(HDPT(next_bp), PACK(n_size - a_size, 0) | PREV_ALLOC);
+            PUTTER(FTPT(next_bp), PACK(n_size - a_size, 0));
+            CLR_PREV_ALLOC(HDPT(NEXT_BLKP(next_bp)));
+            coalesce(next_bp); // 그 뒤 블록이 프리면 합쳐짐
+        }
+        else {
+            PUTTER(HDPT(old_bp), PACK(n_size, 1) | IS_PREV_ALLOCATED(HDPT(old_bp)));
+            SET_PREV_ALLOC(HDPT(NEXT_BLKP(old_bp)));
+        }
+        return old_bp;
+    }
+
+    new_bp = mm_malloc(size); // 새 블록 할당
+
+    if (new_bp == NULL) return NULL;
+
+    copySize = c_size - WSIZE; // 기존 블록 페이로드 크기
+
+    if (size < copySize) // 재할당할 크기가 기존보다 작으면
+        copySize = size; // 원래 size만큼조정
+
+    // 데이터 복사
+    memcpy(new_bp, old_bp, copySize);
+
+    mm_free(old_bp); // 기존 블록 해제
+
+    return new_bp; // 실패시 블록 할당 역할
+}
+
+// mapping : 블록 크기에 맞는 (fl, sl) 리스트 번호
+static void mapping(size_t size, int* fl, int* sl) {
+    int msb; // 최상위 비트 위치
+
+    if (size < SMALL_BLOCK) { // 작은 블록은 8바이트 간격 리스트
+        *fl = 0;
+        *sl = (int)size >> 3;
+    }
+    else {
+        msb = 31 - __builtin_clz((unsigned int)size);
+        *fl = msb - FL_SHIFT + 1;
+        *sl = (int)(size >> (msb - SL_LOG2)) ^ SL_COUNT; // 최상위 비트 다음 SL_LOG2 비트
+    }
+}
+
+// remove_block
+static void remove_block(void* bp) {
+    int fl, sl; // 리스트 인덱스
+
+    mapping(GET_SIZE(HDPT(bp)), &fl, &sl);
+
+    if (SUCC_FREEPT(bp) != NULL) { // 다음 블록이 존재하는 경우
+        SET_PRED_FREEPT(SUCC_FREEPT(bp), PRED_FREEPT(bp)); // 이전 블록 연결 갱신
+    }
+    if (PRED_FREEPT(bp) != NULL) { // 이전 블록이 존재하는 경우
+        SET_SUCC_FREEPT(PRED_FREEPT(bp), SUCC_FREEPT(bp)); // 다음 블록 연결 갱신
+    }
+    else { // 현재 블록이 리스트의 첫 블록인 경우
+        free_lists[fl][sl] = SUCC_FREEPT(bp); // 리스트 헤더 갱신
+        if (free_lists[fl][sl] == NULL) { // 리스트가 비면 비트맵에서 지우기
+            sl_bitmap[fl] &= ~(1u << sl);
+            if (sl_bitmap[fl] == 0) {
+                fl_bitmap &= ~(1u << fl);
+            }
+        }
+    }
+}
+
+// insert_block : 리스트 맨 앞에 추가 (정렬하지 않음)
+static void insert_block(void* bp, size_t size) {
+    int fl, sl; // 리스트 인덱스
+
+    mapping(size, &fl, &sl);
+
+    SET_SUCC_FREEPT(bp, free_lists[fl][sl]);
+    SET_PRED_FREEPT(bp, NULL);
+    if (free_lists[fl][sl] != NULL) {
+        SET_PRED_FREEPT(free_lists[fl][sl], bp);
+    }
+    free_lists[fl][sl] = bp;
+
+    sl_bitmap[fl] |= 1u << sl; // 비어있지 않은 리스트로 표시
+    fl_bitmap |= 1u << fl;
+}